@@ -14,49 +14,665 @@
 
 #include "api.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "bytecode.h"
+#include "constant_folding.h"
 #include "eval.h"
 #include "expression_context.h"
+#include "frame_variables.h"
+#include "memory_cache.h"
 #include "lldb/API/SBError.h"
 #include "lldb/API/SBExecutionContext.h"
 #include "lldb/API/SBFrame.h"
+#include "lldb/API/SBProcess.h"
 #include "lldb/API/SBTarget.h"
+#include "lldb/API/SBThread.h"
+#include "lldb/API/SBType.h"
 #include "lldb/API/SBValue.h"
+#include "llvm/ADT/StringRef.h"
 #include "parser.h"
+#include "pointer.h"
+#include "read_set.h"
+#include "scalar.h"
+#include "stats.h"
+#include "target_cache.h"
+#include "type_info.h"
 #include "value.h"
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t ElapsedNs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              start)
+      .count();
+}
+
+void SetParserError(lldb_eval::Parser& p, lldb::SBError& error) {
+  error.SetError(static_cast<uint32_t>(
+                     lldb_eval::EvalErrorCode::INVALID_EXPRESSION_SYNTAX),
+                 lldb::eErrorTypeGeneric);
+  error.SetErrorString(p.GetError().c_str());
+}
+
+void SetEvalError(const lldb_eval::EvalError& err, lldb::SBError& error) {
+  error.SetError(static_cast<uint32_t>(err.code()), lldb::eErrorTypeGeneric);
+  error.SetErrorString(err.message().c_str());
+}
+
+void SetNotCompiledError(lldb::SBError& error) {
+  error.SetError(static_cast<uint32_t>(lldb_eval::EvalErrorCode::UNKNOWN),
+                 lldb::eErrorTypeGeneric);
+  error.SetErrorString("The expression is not compiled.");
+}
+
+lldb::SBValue ToSbValue(const lldb_eval::Value& value, lldb::SBTarget target) {
+  return value.AsSbValue(target);
+}
+
+// Parses the expression of the given context and folds the constants. Returns
+// nullptr on error.
+lldb_eval::ExprResult Parse(lldb_eval::ExpressionContext& expr_ctx,
+                            lldb::SBError& error, lldb_eval::EvalStats* stats) {
+  Clock::time_point start = Clock::now();
+  lldb_eval::Parser p(expr_ctx);
+  lldb_eval::ExprResult tree = p.Run();
+  if (!p.HasError()) {
+    tree = lldb_eval::FoldConstants(expr_ctx.GetAstArena(), tree);
+  }
+  if (stats) {
+    stats->parse_time_ns += ElapsedNs(start);
+  }
+
+  if (p.HasError()) {
+    SetParserError(p, error);
+    return nullptr;
+  }
+  return tree;
+}
+
+// Evaluates the expression with `eval`, which returns the result or sets the
+// error. The result is converted by `convert`, which is a part of the
+// evaluation time.
+template <typename T, typename EvalFn, typename ConvertFn>
+T EvaluateWith(lldb::SBTarget target, lldb::SBError& error,
+               lldb_eval::EvalStats* stats, EvalFn eval, ConvertFn convert) {
+  Clock::time_point start = Clock::now();
+
+  lldb_eval::EvalError err;
+  lldb_eval::Value result = eval(err);
+  T ret = err ? T() : convert(result, target);
+  if (stats) {
+    stats->eval_time_ns += ElapsedNs(start);
+  }
+
+  if (err) {
+    SetEvalError(err, error);
+  }
+  return ret;
+}
+
+// Evaluates the parsed expression in the given execution context.
+template <typename T, typename ConvertFn>
+T Evaluate(lldb_eval::ExpressionContext& expr_ctx,
+           const lldb_eval::AstNode* tree, lldb::SBExecutionContext exec_ctx,
+           lldb::SBError& error, lldb_eval::EvalStats* stats,
+           ConvertFn convert) {
+  auto eval = [&](lldb_eval::EvalError& err) {
+    lldb_eval::Interpreter interpreter(expr_ctx, exec_ctx);
+    return interpreter.Eval(tree, err);
+  };
+  return EvaluateWith<T>(exec_ctx.GetTarget(), error, stats, eval, convert);
+}
+
+template <typename T, typename ConvertFn>
+T ParseAndEvaluate(lldb::SBFrame frame, const char* expression,
+                   lldb::SBError& error, lldb_eval::EvalStats* stats,
+                   ConvertFn convert) {
+  error.Clear();
+  lldb_eval::StatsScope stats_scope(stats);
+
+  lldb_eval::ExpressionContext expr_ctx(expression,
+                                        lldb::SBExecutionContext(frame));
+  lldb_eval::ExprResult tree = Parse(expr_ctx, error, stats);
+  if (!tree) {
+    return T();
+  }
+  return Evaluate<T>(expr_ctx, tree, expr_ctx.GetExecutionContext(), error,
+                     stats, convert);
+}
+
+// Runs the bytecode of a compiled expression in the given frame.
+template <typename T, typename ConvertFn>
+T EvaluateCompiled(lldb_eval::ExpressionContext* expr_ctx,
+                   const lldb_eval::Bytecode* bytecode, lldb::SBFrame frame,
+                   lldb::SBError& error, lldb_eval::EvalStats* stats,
+                   ConvertFn convert) {
+  error.Clear();
+
+  if (!expr_ctx) {
+    SetNotCompiledError(error);
+    return T();
+  }
+
+  lldb_eval::StatsScope stats_scope(stats);
+  lldb::SBExecutionContext exec_ctx(frame);
+  auto eval = [&](lldb_eval::EvalError& err) {
+    lldb_eval::VirtualMachine vm(*expr_ctx, exec_ctx);
+    return vm.Run(*bytecode, err);
+  };
+  return EvaluateWith<T>(exec_ctx.GetTarget(), error, stats, eval, convert);
+}
+
+// Runs the bytecode of a compiled condition in the given frame. The message of
+// the returned error is formatted only if it's requested.
+lldb_eval::EvalError RunCondition(lldb_eval::ExpressionContext& expr_ctx,
+                                  const lldb_eval::Bytecode& bytecode,
+                                  lldb::SBFrame frame, bool* out,
+                                  lldb_eval::EvalStats* stats) {
+  lldb_eval::StatsScope stats_scope(stats);
+  Clock::time_point start = Clock::now();
+
+  lldb_eval::VirtualMachine vm(expr_ctx, lldb::SBExecutionContext(frame));
+  lldb_eval::EvalError err;
+  vm.RunCondition(bytecode, out, err);
+  if (stats) {
+    stats->eval_time_ns += ElapsedNs(start);
+  }
+  return err;
+}
+
+// Runs `worker` on `num_threads` threads (0 means one per hardware thread),
+// but not more than `max_threads`. The calling thread is one of the workers.
+template <typename WorkerFn>
+void RunWorkers(size_t num_threads, size_t max_threads, WorkerFn worker) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min(num_threads, max_threads);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Scalar of the given kind stored in the raw bits of `EvalResult`.
+lldb_eval::Scalar ScalarFromBits(lldb_eval::EvalResult::Kind kind,
+                                 uint64_t bits) {
+  using Kind = lldb_eval::EvalResult::Kind;
+  switch (kind) {
+    case Kind::BOOL:
+    case Kind::INT32:
+      return lldb_eval::Scalar(static_cast<int32_t>(bits));
+    case Kind::UINT32:
+      return lldb_eval::Scalar(static_cast<uint32_t>(bits));
+    case Kind::INT64:
+      return lldb_eval::Scalar(static_cast<int64_t>(bits));
+    case Kind::UINT64:
+    case Kind::POINTER:
+      return lldb_eval::Scalar(bits);
+    case Kind::FLOAT: {
+      uint32_t float_bits = static_cast<uint32_t>(bits);
+      float value;
+      memcpy(&value, &float_bits, sizeof(value));
+      return lldb_eval::Scalar(value);
+    }
+    case Kind::DOUBLE: {
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return lldb_eval::Scalar(value);
+    }
+    case Kind::INVALID:
+    case Kind::VALUE:
+      break;
+  }
+  return lldb_eval::Scalar();
+}
+
+}  // namespace
+
 namespace lldb_eval {
 
 lldb::SBValue EvaluateExpression(lldb::SBFrame frame, const char* expression,
-                                 lldb::SBError& error) {
+                                 lldb::SBError& error, EvalStats* stats) {
+  return ParseAndEvaluate<lldb::SBValue>(frame, expression, error, stats,
+                                         ToSbValue);
+}
+
+EvalResult EvaluateExpressionNative(lldb::SBFrame frame,
+                                    const char* expression,
+                                    lldb::SBError& error, EvalStats* stats) {
+  return ParseAndEvaluate<EvalResult>(frame, expression, error, stats,
+                                      EvalResult::FromValue);
+}
+
+void EvaluateExpressions(lldb::SBFrame frame, const char* const* expressions,
+                         size_t count, lldb::SBValue* results,
+                         lldb::SBError* errors, EvalStats* stats) {
+  StatsScope stats_scope(stats);
+
+  lldb::SBExecutionContext exec_ctx(frame);
+  std::shared_ptr<TargetCache> target_cache =
+      TargetCache::Get(exec_ctx.GetTarget());
+
+  // All expressions of the batch are evaluated in the same stop, so they can
+  // share the memory cache, the variables of the frame and the properties of
+  // the types.
+  MemoryCache memory_cache(exec_ctx.GetProcess());
+  MemoryCacheScope memory_cache_scope(&memory_cache);
+  FrameVariables frame_variables(frame);
+  FrameVariablesScope frame_variables_scope(&frame_variables);
+  TypeInfoCache type_info_cache;
+  TypeInfoScope type_info_scope(&type_info_cache);
+
+  for (size_t i = 0; i < count; ++i) {
+    errors[i].Clear();
+    results[i] = lldb::SBValue();
+
+    ExpressionContext expr_ctx(expressions[i], exec_ctx, target_cache);
+    ExprResult tree = Parse(expr_ctx, errors[i], stats);
+    if (tree) {
+      results[i] = Evaluate<lldb::SBValue>(expr_ctx, tree, exec_ctx, errors[i],
+                                           stats, ToSbValue);
+    }
+  }
+}
+
+void EvaluateInFrames(const CompiledExpression& expr,
+                      const lldb::SBFrame* frames, size_t count,
+                      lldb::SBValue* results, lldb::SBError* errors,
+                      size_t num_threads) {
+  if (count == 0) {
+    return;
+  }
+  lldb::SBFrame first_frame = frames[0];
+  lldb::SBProcess process = first_frame.GetThread().GetProcess();
+
+  // The workers share the compiled expression. The AST, its arena and the
+  // bytecode are only read after the compilation and the target cache locks
+  // its own mutex. The SB API calls of the evaluation (e.g. on the types) reach
+  // the clang ASTContext of the target, which isn't thread-safe, so the
+  // evaluations hold the evaluation lock of the target. The memory cache, the
+  // variables of the frame, the properties of the types and the stats are per
+  // thread.
+  std::shared_ptr<TargetCache> target_cache =
+      TargetCache::Get(process.GetTarget());
+  std::mutex no_target_mutex;
+  std::mutex& eval_mutex =
+      target_cache ? target_cache->evaluation_mutex() : no_target_mutex;
+
+  // The workers take the frames one by one, so a slow frame doesn't hold up
+  // the others.
+  std::atomic<size_t> next(0);
+  RunWorkers(num_threads, count, [&]() {
+    // The memory cache isn't thread-safe, but the frames evaluated by the
+    // same worker can share one. Same for the properties of the types.
+    MemoryCache memory_cache(process);
+    MemoryCacheScope memory_cache_scope(&memory_cache);
+    TypeInfoCache type_info_cache;
+    TypeInfoScope type_info_scope(&type_info_cache);
+
+    for (size_t i = next++; i < count; i = next++) {
+      std::lock_guard<std::mutex> lock(eval_mutex);
+      results[i] = expr.Evaluate(frames[i], errors[i]);
+    }
+  });
+}
+
+size_t EvaluateInAllThreads(lldb::SBProcess process,
+                            const CompiledExpression& expr,
+                            lldb::SBValue* results, lldb::SBError* errors,
+                            size_t count, size_t num_threads) {
+  count = std::min(count, static_cast<size_t>(process.GetNumThreads()));
+
+  std::vector<lldb::SBFrame> frames(count);
+  for (size_t i = 0; i < count; ++i) {
+    frames[i] = process.GetThreadAtIndex(i).GetFrameAtIndex(0);
+  }
+
+  EvaluateInFrames(expr, frames.data(), count, results, errors, num_threads);
+  return count;
+}
+
+// Holds the parsed expression together with its context. The AST may depend
+// on the context, so both of them share the same lifetime. The bytecode refers
+// to the nodes of the AST.
+class CompiledExpression::Impl {
+ public:
+  Impl(const char* expression, lldb::SBTarget target)
+      : expr_ctx_(expression, lldb::SBExecutionContext(target)),
+        tree_(nullptr) {}
+
+  ExpressionContext expr_ctx_;
+  ExprResult tree_;
+  Bytecode bytecode_;
+};
+
+CompiledExpression Compile(lldb::SBTarget target, const char* expression,
+                           lldb::SBError& error) {
   error.Clear();
 
-  ExpressionContext expr_ctx(expression, lldb::SBExecutionContext(frame));
+  auto impl = std::make_shared<CompiledExpression::Impl>(expression, target);
 
-  Parser p(expr_ctx);
-  auto expr = p.Run();
+  Parser p(impl->expr_ctx_);
+  impl->tree_ = p.Run();
 
   if (p.HasError()) {
-    error.SetError(
-        static_cast<uint32_t>(EvalErrorCode::INVALID_EXPRESSION_SYNTAX),
-        lldb::eErrorTypeGeneric);
-    error.SetErrorString(p.GetError().c_str());
-    return lldb::SBValue();
+    SetParserError(p, error);
+    return CompiledExpression();
   }
 
-  Interpreter eval(expr_ctx);
+  impl->tree_ = FoldConstants(impl->expr_ctx_.GetAstArena(), impl->tree_);
+  impl->bytecode_ = Bytecode::Compile(impl->tree_);
+  return CompiledExpression(std::move(impl));
+}
+
+CompiledExpression::CompiledExpression() {}
 
-  EvalError err;
-  Value result = eval.Eval(expr.get(), err);
+CompiledExpression::CompiledExpression(std::shared_ptr<Impl> impl)
+    : impl_(std::move(impl)) {}
+
+bool CompiledExpression::IsValid() const { return impl_ != nullptr; }
+
+lldb::SBValue CompiledExpression::Evaluate(lldb::SBFrame frame,
+                                           lldb::SBError& error,
+                                           EvalStats* stats) const {
+  return EvaluateCompiled<lldb::SBValue>(
+      impl_ ? &impl_->expr_ctx_ : nullptr, impl_ ? &impl_->bytecode_ : nullptr,
+      frame, error, stats, ToSbValue);
+}
+
+EvalResult CompiledExpression::EvaluateNative(lldb::SBFrame frame,
+                                              lldb::SBError& error,
+                                              EvalStats* stats) const {
+  return EvaluateCompiled<EvalResult>(
+      impl_ ? &impl_->expr_ctx_ : nullptr, impl_ ? &impl_->bytecode_ : nullptr,
+      frame, error, stats, EvalResult::FromValue);
+}
+
+void EvaluateCondition(lldb::SBFrame frame, const CompiledExpression& expr,
+                       bool* out, lldb::SBError& error, EvalStats* stats) {
+  error.Clear();
+  *out = false;
+
+  if (!expr.impl_) {
+    SetNotCompiledError(error);
+    return;
+  }
 
+  EvalError err = RunCondition(expr.impl_->expr_ctx_, expr.impl_->bytecode_,
+                               frame, out, stats);
   if (err) {
-    error.SetError(static_cast<uint32_t>(err.code()), lldb::eErrorTypeGeneric);
-    error.SetErrorString(err.message().c_str());
-    return lldb::SBValue();
+    SetEvalError(err, error);
   }
+}
+
+void EvaluateCondition(lldb::SBFrame frame, const CompiledExpression& expr,
+                       bool* out, uint32_t* error_code, EvalStats* stats) {
+  *out = false;
+
+  if (!expr.impl_) {
+    *error_code = static_cast<uint32_t>(EvalErrorCode::UNKNOWN);
+    return;
+  }
+
+  EvalError err = RunCondition(expr.impl_->expr_ctx_, expr.impl_->bytecode_,
+                               frame, out, stats);
+  *error_code = static_cast<uint32_t>(err.code());
+}
+
+class WatchList::Impl {
+ public:
+  struct Watch {
+    CompiledExpression expr;
+    // Error of the compilation, if the expression is not valid.
+    lldb::SBError compile_error;
+
+    // Result of the last evaluation and its inputs.
+    bool evaluated = false;
+    lldb::SBValue result;
+    lldb::SBError error;
+    ReadSet read_set;
+  };
+
+  explicit Impl(lldb::SBTarget target) : target_(target) {}
+
+  lldb::SBTarget target_;
+  std::vector<Watch> watches_;
+};
+
+WatchList::WatchList(lldb::SBTarget target)
+    : impl_(std::make_shared<Impl>(target)) {}
+
+size_t WatchList::Add(const char* expression) {
+  Impl::Watch watch;
+  watch.expr = Compile(impl_->target_, expression, watch.compile_error);
+  impl_->watches_.push_back(std::move(watch));
+  return impl_->watches_.size() - 1;
+}
+
+size_t WatchList::size() const { return impl_->watches_.size(); }
+
+void WatchList::Evaluate(lldb::SBFrame frame, lldb::SBValue* results,
+                         lldb::SBError* errors, EvalStats* stats) {
+  StatsScope stats_scope(stats);
+  lldb::SBExecutionContext exec_ctx(frame);
+
+  // The inputs of all expressions are checked and read in the same stop.
+  MemoryCache memory_cache(exec_ctx.GetProcess());
+  MemoryCacheScope memory_cache_scope(&memory_cache);
+  FrameVariables frame_variables(frame);
+  FrameVariablesScope frame_variables_scope(&frame_variables);
+  TypeInfoCache type_info_cache;
+  TypeInfoScope type_info_scope(&type_info_cache);
+
+  // Resolves the identifiers of the read sets in the new frame.
+  ExpressionContext lookup_ctx("", exec_ctx);
+  Interpreter lookup_interpreter(lookup_ctx);
+  auto lookup = [&](llvm::StringRef name) {
+    return lookup_interpreter.LookupIdentifier(name);
+  };
+
+  for (size_t i = 0; i < impl_->watches_.size(); ++i) {
+    Impl::Watch& watch = impl_->watches_[i];
+
+    if (!watch.expr.IsValid()) {
+      results[i] = lldb::SBValue();
+      errors[i] = watch.compile_error;
+      continue;
+    }
+
+    if (watch.evaluated && watch.read_set.IsUnchanged(lookup, memory_cache)) {
+      if (stats) {
+        ++stats->results_reused;
+      }
+    } else {
+      watch.read_set.Clear();
+      ReadSetScope read_set_scope(&watch.read_set);
+      watch.result = watch.expr.Evaluate(frame, watch.error, stats);
+      // The result is usually a variable, which is read by the caller.
+      TrackRead(watch.result);
+      watch.evaluated = true;
+    }
+
+    results[i] = watch.result;
+    errors[i] = watch.error;
+  }
+}
+
+EvalResult::EvalResult() : kind_(Kind::INVALID), bits_(0) {}
+
+EvalResult EvalResult::FromValue(const Value& value, lldb::SBTarget target) {
+  EvalResult result;
+  result.target_ = target;
+
+  switch (value.type()) {
+    case Value::Type::INVALID: {
+      return result;
+    }
+    case Value::Type::BOOLEAN: {
+      result.kind_ = Kind::BOOL;
+      result.bits_ = value.AsScalar().AsBool() ? 1 : 0;
+      return result;
+    }
+    case Value::Type::SCALAR: {
+      result.SetScalar(value.AsScalar());
+      return result;
+    }
+    case Value::Type::POINTER: {
+      Pointer pointer = value.AsPointer();
+      result.kind_ = Kind::POINTER;
+      result.bits_ = pointer.addr();
+      result.type_ = pointer.type();
+      return result;
+    }
+    case Value::Type::SB_VALUE: {
+      // Keep the original value, it may be an lvalue or have a type which
+      // doesn't match the native representation (e.g. "char" or "short").
+      result.value_ = value.AsSbValue(target);
+      result.kind_ = Kind::VALUE;
+
+      lldb::SBType type = result.value_.GetType().GetCanonicalType();
+      if (type.IsPointerType()) {
+        result.kind_ = Kind::POINTER;
+        result.bits_ = value.AsPointer().addr();
+      } else if (type.GetBasicType() != lldb::eBasicTypeInvalid) {
+        result.SetScalar(value.AsScalar());
+      }
+      return result;
+    }
+  }
+  return result;
+}
+
+void EvalResult::SetScalar(const Scalar& scalar) {
+  switch (scalar.type_) {
+    case Scalar::Type::INVALID:
+      kind_ = value_.IsValid() ? Kind::VALUE : Kind::INVALID;
+      return;
+    case Scalar::Type::INT32:
+      kind_ = Kind::INT32;
+      bits_ = static_cast<uint32_t>(scalar.value_.int32_);
+      return;
+    case Scalar::Type::UINT32:
+      kind_ = Kind::UINT32;
+      bits_ = scalar.value_.uint32_;
+      return;
+    case Scalar::Type::INT64:
+      kind_ = Kind::INT64;
+      bits_ = static_cast<uint64_t>(scalar.value_.int64_);
+      return;
+    case Scalar::Type::UINT64:
+      kind_ = Kind::UINT64;
+      bits_ = scalar.value_.uint64_;
+      return;
+    case Scalar::Type::FLOAT: {
+      uint32_t float_bits;
+      memcpy(&float_bits, &scalar.value_.float_, sizeof(float_bits));
+      kind_ = Kind::FLOAT;
+      bits_ = float_bits;
+      return;
+    }
+    case Scalar::Type::DOUBLE:
+      kind_ = Kind::DOUBLE;
+      memcpy(&bits_, &scalar.value_.double_, sizeof(bits_));
+      return;
+  }
+}
+
+bool EvalResult::GetBool() const {
+  return ScalarFromBits(kind_, bits_).AsBool();
+}
+
+int64_t EvalResult::GetInt64() const {
+  return ScalarFromBits(kind_, bits_).GetAs<int64_t>();
+}
+
+uint64_t EvalResult::GetUInt64() const {
+  return ScalarFromBits(kind_, bits_).GetAs<uint64_t>();
+}
+
+double EvalResult::GetDouble() const {
+  return ScalarFromBits(kind_, bits_).GetAs<double>();
+}
+
+lldb::SBType EvalResult::GetType() const {
+  // SB API objects are references, copying them is cheap.
+  lldb::SBValue value = value_;
+  if (value.IsValid()) {
+    return value.GetType();
+  }
+
+  lldb::SBTarget target = target_;
+
+  switch (kind_) {
+    case Kind::INVALID:
+    case Kind::VALUE:
+      break;
+    case Kind::BOOL:
+      return target.GetBasicType(lldb::eBasicTypeBool);
+    case Kind::INT32:
+      return target.GetBasicType(lldb::eBasicTypeInt);
+    case Kind::UINT32:
+      return target.GetBasicType(lldb::eBasicTypeUnsignedInt);
+    case Kind::INT64:
+      return target.GetBasicType(lldb::eBasicTypeLongLong);
+    case Kind::UINT64:
+      return target.GetBasicType(lldb::eBasicTypeUnsignedLongLong);
+    case Kind::FLOAT:
+      return target.GetBasicType(lldb::eBasicTypeFloat);
+    case Kind::DOUBLE:
+      return target.GetBasicType(lldb::eBasicTypeDouble);
+    case Kind::POINTER:
+      return type_;
+  }
+  return lldb::SBType();
+}
+
+lldb::SBValue EvalResult::GetSBValue() const {
+  lldb::SBValue value = value_;
+  if (value.IsValid()) {
+    return value;
+  }
+
+  switch (kind_) {
+    case Kind::INVALID:
+    case Kind::VALUE:
+      break;
+    case Kind::BOOL:
+      return Value(bits_ != 0).AsSbValue(target_);
+    case Kind::POINTER:
+      return Value(Pointer(bits_, type_)).AsSbValue(target_);
+    case Kind::INT32:
+    case Kind::UINT32:
+    case Kind::INT64:
+    case Kind::UINT64:
+    case Kind::FLOAT:
+    case Kind::DOUBLE:
+      return Value(ScalarFromBits(kind_, bits_)).AsSbValue(target_);
+  }
+  return lldb::SBValue();
+}
 
-  return result.AsSbValue(expr_ctx.GetExecutionContext().GetTarget());
+TargetCacheStats GetTargetCacheStats(lldb::SBTarget target) {
+  std::shared_ptr<TargetCache> cache = TargetCache::Get(target);
+  return cache ? cache->GetStats() : TargetCacheStats();
 }
 
 }  // namespace lldb_eval
@@ -17,16 +17,272 @@
 #ifndef LLDB_EVAL_API_H_
 #define LLDB_EVAL_API_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
 #include "defines.h"
 #include "lldb/API/SBFrame.h"
+#include "lldb/API/SBProcess.h"
 #include "lldb/API/SBValue.h"
 #include "lldb/API/SBError.h"
+#include "lldb/API/SBTarget.h"
+#include "lldb/API/SBType.h"
 
 namespace lldb_eval {
 
+// Statistics of the evaluation, which help to understand where the time is
+// spent. The functions accepting `EvalStats*` add to the existing values, so
+// one object can accumulate the statistics of many evaluations.
+struct EvalStats {
+  uint64_t parse_time_ns = 0;
+  uint64_t eval_time_ns = 0;
+  // Lookups in the target. The ones answered by the target cache or by the
+  // variables already resolved in the same frame aren't counted.
+  uint64_t find_types_calls = 0;
+  uint64_t find_variable_calls = 0;
+  uint64_t find_global_variables_calls = 0;
+  // Values created by the interpreter, e.g. for results of the arithmetic.
+  uint64_t sb_values_created = 0;
+  // Bytes of the target memory read by the interpreter.
+  uint64_t bytes_read = 0;
+  // The memory is read through a cache in pages. A page is fetched from the
+  // target on a miss.
+  uint64_t memory_cache_hits = 0;
+  uint64_t memory_cache_misses = 0;
+  uint64_t memory_bytes_fetched = 0;
+  // Results of `WatchList` which were reused, since their inputs haven't
+  // changed.
+  uint64_t results_reused = 0;
+};
+
 LLDB_EVAL_API
 lldb::SBValue EvaluateExpression(lldb::SBFrame frame, const char* expression,
-                                 lldb::SBError& error);
+                                 lldb::SBError& error,
+                                 EvalStats* stats = nullptr);
+
+// Evaluates `count` expressions in the context of the same frame. The result
+// and the error of `expressions[i]` are stored in `results[i]` and `errors[i]`,
+// both arrays must have at least `count` elements. This is faster than calling
+// `EvaluateExpression()` in a loop, since the execution context and the lookups
+// in the target are shared by all the expressions in the batch.
+LLDB_EVAL_API
+void EvaluateExpressions(lldb::SBFrame frame, const char* const* expressions,
+                         size_t count, lldb::SBValue* results,
+                         lldb::SBError* errors, EvalStats* stats = nullptr);
+
+class EvalResult;
+
+// Same as `EvaluateExpression()`, but returns scalars and pointers in their
+// native form. This is faster if the caller only needs the number (e.g. for a
+// breakpoint condition), since no `SBValue` is created for the result.
+LLDB_EVAL_API
+EvalResult EvaluateExpressionNative(lldb::SBFrame frame,
+                                    const char* expression,
+                                    lldb::SBError& error,
+                                    EvalStats* stats = nullptr);
+
+class CompiledExpression;
+
+// Parses the expression in the context of the given target. The result can be
+// evaluated many times (e.g. in different frames or on every stop) without
+// parsing the expression again. If the expression is not valid, the `error` is
+// set and the returned object is not valid.
+LLDB_EVAL_API
+CompiledExpression Compile(lldb::SBTarget target, const char* expression,
+                           lldb::SBError& error);
+
+// Evaluates the compiled expression as a condition (e.g. of a conditional
+// breakpoint) and stores its truth value in `out`. The result is converted the
+// same way as the condition of the ternary operator, no `SBValue` is created
+// for it. On error `out` is set to false.
+LLDB_EVAL_API
+void EvaluateCondition(lldb::SBFrame frame, const CompiledExpression& expr,
+                       bool* out, lldb::SBError& error,
+                       EvalStats* stats = nullptr);
+
+// Same as above, but reports only the error code, i.e. `SBError::GetError()`
+// of the other overload (0 on success). The message of the error is never
+// formatted, which makes the failing evaluations cheaper, e.g. if the condition
+// refers to a variable which is not in scope at some of the hits.
+LLDB_EVAL_API
+void EvaluateCondition(lldb::SBFrame frame, const CompiledExpression& expr,
+                       bool* out, uint32_t* error_code,
+                       EvalStats* stats = nullptr);
+
+// Handle to a parsed expression, produced by `Compile()`. It's cheap to copy,
+// all copies share the same parsed expression.
+class LLDB_EVAL_API CompiledExpression {
+ public:
+  CompiledExpression();
+
+  bool IsValid() const;
+
+  // Evaluates the expression in the context of the given frame. The frame is
+  // expected to belong to the target the expression was compiled for.
+  lldb::SBValue Evaluate(lldb::SBFrame frame, lldb::SBError& error,
+                         EvalStats* stats = nullptr) const;
+
+  // Same as `Evaluate()`, but returns the result in the native form.
+  EvalResult EvaluateNative(lldb::SBFrame frame, lldb::SBError& error,
+                            EvalStats* stats = nullptr) const;
+
+ private:
+  friend CompiledExpression Compile(lldb::SBTarget target,
+                                    const char* expression,
+                                    lldb::SBError& error);
+  friend void EvaluateCondition(lldb::SBFrame frame,
+                                const CompiledExpression& expr, bool* out,
+                                lldb::SBError& error, EvalStats* stats);
+  friend void EvaluateCondition(lldb::SBFrame frame,
+                                const CompiledExpression& expr, bool* out,
+                                uint32_t* error_code, EvalStats* stats);
+
+  class Impl;
+  explicit CompiledExpression(std::shared_ptr<Impl> impl);
+
+  std::shared_ptr<Impl> impl_;
+};
+
+// Evaluates the compiled expression in each of the `count` frames. The result
+// and the error of `frames[i]` are stored in `results[i]` and `errors[i]`. The
+// frames must belong to the same stopped process. The expression is parsed
+// only once and the lookups which don't depend on the frame (e.g. types) are
+// shared. The frames are distributed over `num_threads` worker threads (0 means
+// one per hardware thread), but the evaluations in the same target are
+// serialized, since the type system of LLDB isn't thread-safe. The results
+// don't depend on the number of threads.
+LLDB_EVAL_API
+void EvaluateInFrames(const CompiledExpression& expr,
+                      const lldb::SBFrame* frames, size_t count,
+                      lldb::SBValue* results, lldb::SBError* errors,
+                      size_t num_threads = 1);
+
+// Evaluates the compiled expression in the top frame of every thread of the
+// stopped process, e.g. to inspect the state of all threads of a hung
+// program. The arrays must have at least `count` elements, which is expected
+// to be `process.GetNumThreads()`. Returns the number of evaluated threads.
+LLDB_EVAL_API
+size_t EvaluateInAllThreads(lldb::SBProcess process,
+                            const CompiledExpression& expr,
+                            lldb::SBValue* results, lldb::SBError* errors,
+                            size_t count, size_t num_threads = 1);
+
+// List of expressions evaluated on every stop, e.g. in the watch window of a
+// debugger. The inputs of every evaluation (the variables the identifiers
+// resolve to and the memory the expression reads) are recorded. On the next
+// stop only the expressions whose inputs have changed are evaluated again, the
+// previous results are returned for the rest. It's cheap to copy, all copies
+// share the same list.
+class LLDB_EVAL_API WatchList {
+ public:
+  explicit WatchList(lldb::SBTarget target);
+
+  // Adds the expression to the list and returns its index. Syntax errors are
+  // reported by `Evaluate()`.
+  size_t Add(const char* expression);
+
+  size_t size() const;
+
+  // Evaluates the expressions in the given frame. The result and the error of
+  // the expression `i` are stored in `results[i]` and `errors[i]`, both arrays
+  // must have at least `size()` elements.
+  void Evaluate(lldb::SBFrame frame, lldb::SBValue* results,
+                lldb::SBError* errors, EvalStats* stats = nullptr);
+
+ private:
+  class Impl;
+  std::shared_ptr<Impl> impl_;
+};
+
+class Scalar;
+class Value;
+
+// Result of the evaluation in the native form: a type tag and the raw bits of
+// the scalar or the pointer. The type and the `SBValue` of the result are only
+// created on demand. Results of other types (e.g. structs or arrays) are kept
+// as `SBValue`.
+class LLDB_EVAL_API EvalResult {
+ public:
+  enum class Kind {
+    INVALID,
+    BOOL,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    POINTER,
+    // Not representable natively, use `GetSBValue()`.
+    VALUE,
+  };
+
+ public:
+  EvalResult();
+
+  bool IsValid() const { return kind_ != Kind::INVALID; }
+  Kind kind() const { return kind_; }
+
+  // Bits of the value zero-extended to 64 bits, i.e. the IEEE representation
+  // of floating point numbers and the address of pointers.
+  uint64_t GetRawBits() const { return bits_; }
+
+  // The value converted according to the C++ rules. Pointers are converted to
+  // their addresses. Return 0 for `INVALID` and `VALUE` results.
+  bool GetBool() const;
+  int64_t GetInt64() const;
+  uint64_t GetUInt64() const;
+  double GetDouble() const;
+
+  // The type of the result. If the expression evaluated to a variable, this is
+  // the declared type of the variable (e.g. "char" for `INT32`).
+  lldb::SBType GetType() const;
+
+  // Creates the `SBValue` of the result. Variables are returned as is, so the
+  // result can still be an lvalue.
+  lldb::SBValue GetSBValue() const;
+
+ private:
+  friend EvalResult EvaluateExpressionNative(lldb::SBFrame frame,
+                                             const char* expression,
+                                             lldb::SBError& error,
+                                             EvalStats* stats);
+  friend class CompiledExpression;
+
+  static EvalResult FromValue(const Value& value, lldb::SBTarget target);
+  void SetScalar(const Scalar& scalar);
+
+  Kind kind_;
+  uint64_t bits_;
+  lldb::SBTarget target_;
+  // Type of the pointer results.
+  lldb::SBType type_;
+  // Results which are not created by the interpreter (e.g. variables).
+  lldb::SBValue value_;
+};
+
+// Hit/miss counters of a single cache.
+struct CacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+// Statistics of the caches, which are shared by all expressions evaluated in
+// the same target. The caches are dropped when the modules of the target are
+// loaded or unloaded, each time is counted as an invalidation.
+struct TargetCacheStats {
+  // Type lookups by name (e.g. in C-style casts).
+  CacheStats types;
+  // Global and static variable lookups by name.
+  CacheStats globals;
+  // Layout lookups of the members of records (e.g. in "a->b").
+  CacheStats members;
+  uint64_t invalidations = 0;
+};
+
+LLDB_EVAL_API
+TargetCacheStats GetTargetCacheStats(lldb::SBTarget target);
 
 }  // namespace lldb_eval
 
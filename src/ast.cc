@@ -14,6 +14,10 @@
 
 #include "ast.h"
 
+#include <cstring>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FormatVariadic.h"
 
 namespace {
@@ -30,6 +34,21 @@ void StringReplace(std::string& str, const std::string& old_value,
 
 namespace lldb_eval {
 
+AstArena::~AstArena() {
+  for (Destructor* d = destructors_; d != nullptr; d = d->next) {
+    d->destroy(d->object);
+  }
+}
+
+llvm::StringRef AstArena::CopyString(llvm::StringRef str) {
+  char* data = allocator_.Allocate<char>(str.size() + 1);
+  if (!str.empty()) {
+    std::memcpy(data, str.data(), str.size());
+  }
+  data[str.size()] = '\0';
+  return llvm::StringRef(data, str.size());
+}
+
 std::string TypeDeclaration::GetName() const {
   // Full name is a combination of a base name and pointer operators.
   std::string name = GetBaseName();
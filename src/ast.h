@@ -17,11 +17,16 @@
 #ifndef LLDB_EVAL_AST_H_
 #define LLDB_EVAL_AST_H_
 
-#include <memory>
+#include <cstddef>
+#include <new>
 #include <string>
-#include <vector>
+#include <type_traits>
+#include <utility>
 
 #include "clang/Basic/TokenKinds.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
 #include "scalar.h"
 
 namespace lldb_eval {
@@ -42,33 +47,109 @@ class TypeDeclaration {
   // True if the type is builtin, false if it's user-defined.
   bool is_builtin_;
 
-  // List of base typenames, e.g. ["long", "long"] or ["uint64_t"].
-  std::vector<std::string> typenames_;
+  // List of base typenames, e.g. ["long", "long"] or ["uint64_t"]. Names refer
+  // either to the expression text or to the AST arena.
+  llvm::SmallVector<llvm::StringRef, 2> typenames_;
 
   // Pointer and reference operators (* and &).
-  std::vector<clang::tok::TokenKind> ptr_operators_;
+  llvm::SmallVector<clang::tok::TokenKind, 2> ptr_operators_;
+};
+
+// Owns the memory of the AST. Nodes and the strings they refer to are allocated
+// in a bump allocator and freed all at once when the arena is destroyed.
+// Objects with non-trivial destructors are destroyed in the reverse order of
+// creation.
+class AstArena {
+ public:
+  AstArena() : destructors_(nullptr) {}
+  ~AstArena();
+
+  AstArena(const AstArena&) = delete;
+  AstArena& operator=(const AstArena&) = delete;
+
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    T* object = new (allocator_.Allocate<T>()) T(std::forward<Args>(args)...);
+    RegisterDestructor(object, std::is_trivially_destructible<T>());
+    return object;
+  }
+
+  // Copies the string into the arena. The copy is null-terminated.
+  llvm::StringRef CopyString(llvm::StringRef str);
+
+  size_t GetNumSlabs() const { return allocator_.GetNumSlabs(); }
+  size_t GetBytesAllocated() const { return allocator_.getBytesAllocated(); }
+
+ private:
+  struct Destructor {
+    void (*destroy)(void* object);
+    void* object;
+    Destructor* next;
+  };
+
+  template <typename T>
+  void RegisterDestructor(T*, std::true_type) {}
+
+  template <typename T>
+  void RegisterDestructor(T* object, std::false_type) {
+    auto destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+    destructors_ = new (allocator_.Allocate<Destructor>())
+        Destructor{destroy, object, destructors_};
+  }
+
+ private:
+  llvm::BumpPtrAllocator allocator_;
+  Destructor* destructors_;
 };
 
 class Visitor;
 
+// AST nodes are allocated in AstArena and are never deleted individually.
 // TODO(werat): Save original token and the source position, so we can give
 // better diagnostic messages during the evaluation.
 class AstNode {
  public:
-  virtual ~AstNode() {}
+  // Kind of the node, which allows to dispatch on the node type without the
+  // virtual calls of `Accept()` (e.g. in the interpreter).
+  enum class Kind {
+    // ErrorNode.
+    INVALID,
+    BOOLEAN_LITERAL,
+    NUMERIC_LITERAL,
+    IDENTIFIER,
+    C_STYLE_CAST,
+    MEMBER_OF,
+    BINARY_OP,
+    UNARY_OP,
+    TERNARY_OP,
+  };
 
+ public:
   virtual void Accept(Visitor* v) const = 0;
+
+  Kind kind() const { return kind_; }
+
+ protected:
+  explicit AstNode(Kind kind) : kind_(kind) {}
+  ~AstNode() = default;
+
+ private:
+  Kind kind_;
 };
 
-using ExprResult = std::unique_ptr<AstNode>;
+using ExprResult = AstNode*;
 
 class ErrorNode : public AstNode {
+ public:
+  ErrorNode() : AstNode(Kind::INVALID) {}
+
   void Accept(Visitor* v) const override;
 };
 
 class BooleanLiteralNode : public AstNode {
  public:
-  explicit BooleanLiteralNode(bool value) : value_(value) {}
+  explicit BooleanLiteralNode(bool value)
+      : AstNode(Kind::BOOLEAN_LITERAL), value_(value) {}
 
   void Accept(Visitor* v) const override;
 
@@ -80,7 +161,8 @@ class BooleanLiteralNode : public AstNode {
 
 class NumericLiteralNode : public AstNode {
  public:
-  explicit NumericLiteralNode(const Scalar& value) : value_(value) {}
+  explicit NumericLiteralNode(const Scalar& value)
+      : AstNode(Kind::NUMERIC_LITERAL), value_(value) {}
 
   void Accept(Visitor* v) const override;
 
@@ -92,27 +174,32 @@ class NumericLiteralNode : public AstNode {
 
 class IdentifierNode : public AstNode {
  public:
-  explicit IdentifierNode(const std::string& name) : name_(name) {}
+  // The name must outlive the node, i.e. it should refer either to the
+  // expression text or to the AST arena.
+  explicit IdentifierNode(llvm::StringRef name)
+      : AstNode(Kind::IDENTIFIER), name_(name) {}
 
   void Accept(Visitor* v) const override;
 
-  std::string name() const { return name_; }
+  llvm::StringRef name() const { return name_; }
 
  private:
-  std::string name_;
+  llvm::StringRef name_;
 };
 
-using IdExpression = std::unique_ptr<IdentifierNode>;
+using IdExpression = IdentifierNode*;
 
 class CStyleCastNode : public AstNode {
  public:
   CStyleCastNode(TypeDeclaration type_decl, ExprResult rhs)
-      : type_decl_(type_decl), rhs_(std::move(rhs)) {}
+      : AstNode(Kind::C_STYLE_CAST),
+        type_decl_(std::move(type_decl)),
+        rhs_(rhs) {}
 
   void Accept(Visitor* v) const override;
 
-  TypeDeclaration type_decl() const { return type_decl_; }
-  AstNode* rhs() const { return rhs_.get(); }
+  const TypeDeclaration& type_decl() const { return type_decl_; }
+  AstNode* rhs() const { return rhs_; }
 
  private:
   TypeDeclaration type_decl_;
@@ -128,13 +215,16 @@ class MemberOfNode : public AstNode {
 
  public:
   MemberOfNode(Type type, ExprResult lhs, IdExpression member_id)
-      : type_(type), lhs_(std::move(lhs)), member_id_(std::move(member_id)) {}
+      : AstNode(Kind::MEMBER_OF),
+        type_(type),
+        lhs_(lhs),
+        member_id_(member_id) {}
 
   void Accept(Visitor* v) const override;
 
   Type type() const { return type_; }
-  AstNode* lhs() const { return lhs_.get(); }
-  IdentifierNode* member_id() const { return member_id_.get(); }
+  AstNode* lhs() const { return lhs_; }
+  IdentifierNode* member_id() const { return member_id_; }
 
  private:
   Type type_;
@@ -145,14 +235,14 @@ class MemberOfNode : public AstNode {
 class BinaryOpNode : public AstNode {
  public:
   BinaryOpNode(clang::tok::TokenKind op, ExprResult lhs, ExprResult rhs)
-      : op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+      : AstNode(Kind::BINARY_OP), op_(op), lhs_(lhs), rhs_(rhs) {}
 
   void Accept(Visitor* v) const override;
 
   clang::tok::TokenKind op() const { return op_; }
   std::string op_name() const { return clang::tok::getTokenName(op_); }
-  AstNode* lhs() const { return lhs_.get(); }
-  AstNode* rhs() const { return rhs_.get(); }
+  AstNode* lhs() const { return lhs_; }
+  AstNode* rhs() const { return rhs_; }
 
  private:
   // TODO(werat): Use custom enum with binary operators.
@@ -164,13 +254,13 @@ class BinaryOpNode : public AstNode {
 class UnaryOpNode : public AstNode {
  public:
   UnaryOpNode(clang::tok::TokenKind op, ExprResult rhs)
-      : op_(op), rhs_(std::move(rhs)) {}
+      : AstNode(Kind::UNARY_OP), op_(op), rhs_(rhs) {}
 
   void Accept(Visitor* v) const override;
 
   clang::tok::TokenKind op() const { return op_; }
   std::string op_name() const { return clang::tok::getTokenName(op_); }
-  AstNode* rhs() const { return rhs_.get(); }
+  AstNode* rhs() const { return rhs_; }
 
  private:
   // TODO(werat): Use custom enum with unary operators.
@@ -181,13 +271,13 @@ class UnaryOpNode : public AstNode {
 class TernaryOpNode : public AstNode {
  public:
   TernaryOpNode(ExprResult cond, ExprResult lhs, ExprResult rhs)
-      : cond_(std::move(cond)), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+      : AstNode(Kind::TERNARY_OP), cond_(cond), lhs_(lhs), rhs_(rhs) {}
 
   void Accept(Visitor* v) const override;
 
-  AstNode* cond() const { return cond_.get(); }
-  AstNode* lhs() const { return lhs_.get(); }
-  AstNode* rhs() const { return rhs_.get(); }
+  AstNode* cond() const { return cond_; }
+  AstNode* lhs() const { return lhs_; }
+  AstNode* rhs() const { return rhs_; }
 
  private:
   ExprResult cond_;
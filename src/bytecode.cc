@@ -0,0 +1,279 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bytecode.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "ast.h"
+#include "clang/Basic/TokenKinds.h"
+#include "eval.h"
+#include "frame_variables.h"
+#include "memory_cache.h"
+#include "type_info.h"
+#include "value.h"
+
+namespace lldb_eval {
+
+// Emits the instructions in the post-order of the AST. The registers are
+// allocated as a stack: a node is evaluated into the register `dst_` and its
+// operands into `dst_` and the registers above it.
+class BytecodeCompiler : Visitor {
+ public:
+  explicit BytecodeCompiler(Bytecode* bytecode)
+      : bytecode_(bytecode), dst_(0) {}
+
+  void Emit(const AstNode* node, uint32_t dst) {
+    uint32_t saved_dst = dst_;
+    dst_ = dst;
+    if (dst >= bytecode_->num_registers_) {
+      bytecode_->num_registers_ = dst + 1;
+    }
+    node->Accept(this);
+    dst_ = saved_dst;
+  }
+
+ private:
+  void Visit(const ErrorNode* node) override { EmitEvalNode(node); }
+
+  void Visit(const BooleanLiteralNode* node) override {
+    EmitConst(Value(node->value()));
+  }
+
+  void Visit(const NumericLiteralNode* node) override {
+    EmitConst(Value(node->value()));
+  }
+
+  void Visit(const IdentifierNode* node) override {
+    Add(OpCode::LOAD_VARIABLE, dst_, 0, 0, AddNode(node));
+  }
+
+  void Visit(const CStyleCastNode* node) override {
+    // The type is resolved before the operand is evaluated, let the tree
+    // walker do both to keep the order of the errors.
+    EmitEvalNode(node);
+  }
+
+  void Visit(const MemberOfNode* node) override {
+    Emit(node->lhs(), dst_);
+    Add(OpCode::MEMBER_OF, dst_, dst_, 0, AddNode(node));
+  }
+
+  void Visit(const BinaryOpNode* node) override {
+    clang::tok::TokenKind op = node->op();
+
+    // The right operand is skipped if the left one decides the result.
+    if (op == clang::tok::ampamp || op == clang::tok::pipepipe) {
+      Emit(node->lhs(), dst_);
+      size_t jump =
+          Add(op == clang::tok::ampamp ? OpCode::AND_JUMP : OpCode::OR_JUMP,
+              dst_, dst_, 0, 0);
+      Emit(node->rhs(), dst_);
+      Add(OpCode::TO_BOOL, dst_, dst_, 0, 0);
+      PatchJump(jump);
+      return;
+    }
+
+    Emit(node->lhs(), dst_);
+    Emit(node->rhs(), dst_ + 1);
+    size_t index = Add(OpCode::BINARY_OP, dst_, dst_, dst_ + 1, 0);
+    bytecode_->instructions_[index].op = op;
+  }
+
+  void Visit(const UnaryOpNode* node) override {
+    Emit(node->rhs(), dst_);
+    size_t index = Add(OpCode::UNARY_OP, dst_, dst_, 0, 0);
+    bytecode_->instructions_[index].op = node->op();
+  }
+
+  void Visit(const TernaryOpNode* node) override {
+    Emit(node->cond(), dst_);
+    size_t jump_to_rhs = Add(OpCode::JUMP_IF_FALSE, dst_, dst_, 0, 0);
+    Emit(node->lhs(), dst_);
+    size_t jump_to_end = Add(OpCode::JUMP, dst_, 0, 0, 0);
+    PatchJump(jump_to_rhs);
+    Emit(node->rhs(), dst_);
+    PatchJump(jump_to_end);
+  }
+
+ private:
+  size_t Add(OpCode opcode, uint32_t dst, uint32_t a, uint32_t b,
+             uint32_t operand) {
+    bytecode_->instructions_.push_back(
+        {opcode, clang::tok::unknown, dst, a, b, operand});
+    return bytecode_->instructions_.size() - 1;
+  }
+
+  uint32_t AddNode(const AstNode* node) {
+    bytecode_->nodes_.push_back(node);
+    return static_cast<uint32_t>(bytecode_->nodes_.size() - 1);
+  }
+
+  void EmitConst(const Value& value) {
+    bytecode_->constants_.push_back(value);
+    Add(OpCode::LOAD_CONST, dst_, 0, 0,
+        static_cast<uint32_t>(bytecode_->constants_.size() - 1));
+  }
+
+  void EmitEvalNode(const AstNode* node) {
+    Add(OpCode::EVAL_NODE, dst_, 0, 0, AddNode(node));
+  }
+
+  // Sets the target of the jump to the next instruction.
+  void PatchJump(size_t index) {
+    bytecode_->instructions_[index].operand =
+        static_cast<uint32_t>(bytecode_->instructions_.size());
+  }
+
+ private:
+  Bytecode* bytecode_;
+  uint32_t dst_;
+};
+
+Bytecode Bytecode::Compile(const AstNode* tree) {
+  Bytecode bytecode;
+  BytecodeCompiler compiler(&bytecode);
+  compiler.Emit(tree, 0);
+  return bytecode;
+}
+
+Value VirtualMachine::Run(const Bytecode& bytecode, EvalError& error) {
+  // Same as in `Interpreter::Eval()`, the tree walker uses the cache installed
+  // here for the nodes it evaluates.
+  MemoryCache memory_cache(interpreter_.target_.GetProcess());
+  MemoryCacheScope memory_cache_scope(
+      GetCurrentMemoryCache() ? GetCurrentMemoryCache() : &memory_cache);
+  FrameVariables frame_variables(interpreter_.frame_);
+  FrameVariables* current_variables = GetCurrentFrameVariables();
+  FrameVariablesScope frame_variables_scope(
+      current_variables && current_variables->frame().IsEqual(
+                               interpreter_.frame_)
+          ? current_variables
+          : &frame_variables);
+  TypeInfoCache type_info_cache;
+  TypeInfoScope type_info_scope(GetCurrentTypeInfoCache()
+                                    ? GetCurrentTypeInfoCache()
+                                    : &type_info_cache);
+
+  if (registers_.size() < bytecode.num_registers_) {
+    registers_.resize(bytecode.num_registers_);
+  }
+
+  EvalError& err = interpreter_.error_;
+  const std::vector<Instruction>& code = bytecode.instructions_;
+  size_t pc = 0;
+
+  while (pc < code.size()) {
+    const Instruction& in = code[pc++];
+
+    switch (in.opcode) {
+      case OpCode::LOAD_CONST:
+        registers_[in.dst] = bytecode.constants_[in.operand];
+        break;
+
+      case OpCode::LOAD_VARIABLE:
+        registers_[in.dst] = interpreter_.EvaluateIdentifier(
+            static_cast<const IdentifierNode*>(bytecode.nodes_[in.operand]));
+        break;
+
+      case OpCode::MEMBER_OF:
+        registers_[in.dst] = interpreter_.EvaluateMemberOf(
+            static_cast<const MemberOfNode*>(bytecode.nodes_[in.operand]),
+            registers_[in.a]);
+        break;
+
+      case OpCode::BINARY_OP:
+        registers_[in.dst] = interpreter_.EvaluateBinaryOp(
+            in.op, registers_[in.a], registers_[in.b]);
+        break;
+
+      case OpCode::UNARY_OP:
+        registers_[in.dst] =
+            interpreter_.EvaluateUnaryOp(in.op, registers_[in.a]);
+        break;
+
+      case OpCode::TO_BOOL:
+        if (interpreter_.BoolConvertible(registers_[in.a])) {
+          registers_[in.dst] = Value(registers_[in.a].AsBool());
+        }
+        break;
+
+      case OpCode::AND_JUMP:
+      case OpCode::OR_JUMP: {
+        Value& cond = registers_[in.a];
+        if (!interpreter_.BoolConvertible(cond)) {
+          break;
+        }
+        bool value = cond.AsBool();
+        if (value == (in.opcode == OpCode::OR_JUMP)) {
+          registers_[in.dst] = Value(value);
+          pc = in.operand;
+        }
+        break;
+      }
+
+      case OpCode::JUMP_IF_FALSE:
+        if (interpreter_.BoolConvertible(registers_[in.a]) &&
+            !registers_[in.a].AsBool()) {
+          pc = in.operand;
+        }
+        break;
+
+      case OpCode::JUMP:
+        pc = in.operand;
+        break;
+
+      case OpCode::EVAL_NODE:
+        registers_[in.dst] =
+            interpreter_.EvalNode(bytecode.nodes_[in.operand]);
+        break;
+    }
+
+    if (err) {
+      // Grab the error and reset the interpreter state.
+      error = err;
+      err.Clear();
+      return Value();
+    }
+  }
+
+  error.Clear();
+  return std::move(registers_[0]);
+}
+
+bool VirtualMachine::RunCondition(const Bytecode& bytecode, bool* result,
+                                  EvalError& error) {
+  // Share the memory cache with `Run()`, the result is usually a variable
+  // which is read only by the conversion.
+  MemoryCache memory_cache(interpreter_.target_.GetProcess());
+  MemoryCacheScope memory_cache_scope(
+      GetCurrentMemoryCache() ? GetCurrentMemoryCache() : &memory_cache);
+
+  Value value = Run(bytecode, error);
+  if (error) {
+    return false;
+  }
+
+  if (!interpreter_.BoolConvertible(value)) {
+    error = interpreter_.error_;
+    interpreter_.error_.Clear();
+    return false;
+  }
+
+  *result = value.AsBool();
+  return true;
+}
+
+}  // namespace lldb_eval
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_BYTECODE_H_
+#define LLDB_EVAL_BYTECODE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.h"
+#include "clang/Basic/TokenKinds.h"
+#include "eval.h"
+#include "expression_context.h"
+#include "lldb/API/SBExecutionContext.h"
+#include "value.h"
+
+namespace lldb_eval {
+
+enum class OpCode : uint8_t {
+  // dst = constants[operand]
+  LOAD_CONST,
+  // dst = variable named by nodes[operand], which is an `IdentifierNode`.
+  LOAD_VARIABLE,
+  // dst = member of `a` selected by nodes[operand], which is a `MemberOfNode`.
+  MEMBER_OF,
+  // dst = a op b
+  BINARY_OP,
+  // dst = op a
+  UNARY_OP,
+  // dst = bool(a)
+  TO_BOOL,
+  // If `a` decides the result of "&&" ("||"), dst = bool(a) and jump to
+  // `operand`.
+  AND_JUMP,
+  OR_JUMP,
+  // Jump to `operand` if `a` is false.
+  JUMP_IF_FALSE,
+  // Jump to `operand`.
+  JUMP,
+  // dst = nodes[operand] evaluated by the tree walker.
+  EVAL_NODE,
+};
+
+// Instruction of the register machine. `dst`, `a` and `b` are register
+// numbers, the meaning of `operand` depends on the opcode.
+struct Instruction {
+  OpCode opcode;
+  clang::tok::TokenKind op;
+  uint32_t dst;
+  uint32_t a;
+  uint32_t b;
+  uint32_t operand;
+};
+
+// Flat form of the AST, which is evaluated by `VirtualMachine` without the
+// recursion and the virtual calls of the tree walker. The bytecode refers to
+// the nodes of the AST, so it must not outlive the expression context.
+class Bytecode {
+ public:
+  Bytecode() : num_registers_(0) {}
+
+  // Compiles the AST into the bytecode, the result of the evaluation is left
+  // in the register 0.
+  static Bytecode Compile(const AstNode* tree);
+
+  const std::vector<Instruction>& instructions() const {
+    return instructions_;
+  }
+  uint32_t num_registers() const { return num_registers_; }
+
+ private:
+  friend class BytecodeCompiler;
+  friend class VirtualMachine;
+
+  std::vector<Instruction> instructions_;
+  std::vector<Value> constants_;
+  std::vector<const AstNode*> nodes_;
+  uint32_t num_registers_;
+};
+
+// Evaluates the bytecode in the given execution context. The operations are
+// evaluated by the same code as in `Interpreter`, so the results and the
+// errors are the same. The machine can be reused to run many programs (or the
+// same one many times).
+class VirtualMachine {
+ public:
+  explicit VirtualMachine(ExpressionContext& expr_ctx)
+      : interpreter_(expr_ctx) {}
+
+  VirtualMachine(ExpressionContext& expr_ctx,
+                 lldb::SBExecutionContext exec_ctx)
+      : interpreter_(expr_ctx, exec_ctx) {}
+
+  Value Run(const Bytecode& bytecode, EvalError& error);
+
+  // Runs the bytecode and converts the result to bool, the same way as the
+  // condition of the ternary operator. Returns false on error.
+  bool RunCondition(const Bytecode& bytecode, bool* result, EvalError& error);
+
+ private:
+  Interpreter interpreter_;
+  std::vector<Value> registers_;
+};
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_BYTECODE_H_
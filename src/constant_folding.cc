@@ -0,0 +1,273 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "constant_folding.h"
+
+#include <cstdint>
+
+#include "ast.h"
+#include "clang/Basic/TokenKinds.h"
+#include "scalar.h"
+
+namespace {
+
+using lldb_eval::AstArena;
+using lldb_eval::AstNode;
+using lldb_eval::ExprResult;
+using lldb_eval::Scalar;
+
+bool IsInteger(const Scalar& value) {
+  return value.type_ == Scalar::Type::INT32 ||
+         value.type_ == Scalar::Type::UINT32 ||
+         value.type_ == Scalar::Type::INT64 ||
+         value.type_ == Scalar::Type::UINT64;
+}
+
+// Subtree after folding. Literals are the only constants, the values of the
+// boolean literals are the same as the interpreter uses for them (i.e. 0 and 1
+// of type int).
+struct Folded {
+  ExprResult node;
+  bool is_constant;
+  Scalar value;
+};
+
+class ConstantFolder : lldb_eval::Visitor {
+ public:
+  explicit ConstantFolder(AstArena& arena) : arena_(&arena) {}
+
+  Folded Fold(const AstNode* node) {
+    node->Accept(this);
+    return result_;
+  }
+
+ private:
+  void Visit(const lldb_eval::ErrorNode* node) override { Keep(node); }
+
+  void Visit(const lldb_eval::BooleanLiteralNode* node) override {
+    Keep(node);
+    result_.is_constant = true;
+    result_.value = Scalar(static_cast<int32_t>(node->value()));
+  }
+
+  void Visit(const lldb_eval::NumericLiteralNode* node) override {
+    Keep(node);
+    result_.is_constant = true;
+    result_.value = node->value();
+  }
+
+  void Visit(const lldb_eval::IdentifierNode* node) override { Keep(node); }
+
+  void Visit(const lldb_eval::CStyleCastNode* node) override {
+    // The cast needs the target to resolve the type, fold only the operand.
+    Folded rhs = Fold(node->rhs());
+    if (rhs.node == node->rhs()) {
+      Keep(node);
+      return;
+    }
+    SetNode(arena_->Create<lldb_eval::CStyleCastNode>(node->type_decl(),
+                                                      rhs.node));
+  }
+
+  void Visit(const lldb_eval::MemberOfNode* node) override {
+    Folded lhs = Fold(node->lhs());
+    if (lhs.node == node->lhs()) {
+      Keep(node);
+      return;
+    }
+    SetNode(arena_->Create<lldb_eval::MemberOfNode>(node->type(), lhs.node,
+                                                    node->member_id()));
+  }
+
+  void Visit(const lldb_eval::BinaryOpNode* node) override {
+    Folded lhs = Fold(node->lhs());
+    clang::tok::TokenKind op = node->op();
+
+    // The right operand of the logical operators isn't evaluated if the left
+    // one decides the result, so it doesn't matter what it is.
+    if (lhs.is_constant) {
+      if (op == clang::tok::ampamp && !lhs.value.AsBool()) {
+        SetBoolean(false);
+        return;
+      }
+      if (op == clang::tok::pipepipe && lhs.value.AsBool()) {
+        SetBoolean(true);
+        return;
+      }
+    }
+
+    Folded rhs = Fold(node->rhs());
+    if (lhs.is_constant && rhs.is_constant && FoldBinaryOp(op, lhs, rhs)) {
+      return;
+    }
+
+    if (lhs.node == node->lhs() && rhs.node == node->rhs()) {
+      Keep(node);
+      return;
+    }
+    SetNode(arena_->Create<lldb_eval::BinaryOpNode>(op, lhs.node, rhs.node));
+  }
+
+  void Visit(const lldb_eval::UnaryOpNode* node) override {
+    Folded rhs = Fold(node->rhs());
+    clang::tok::TokenKind op = node->op();
+
+    if (rhs.is_constant) {
+      if (op == clang::tok::plus && SetScalar(rhs.value)) {
+        return;
+      }
+      if (op == clang::tok::minus && SetScalar(rhs.value * Scalar(-1))) {
+        return;
+      }
+    }
+
+    if (rhs.node == node->rhs()) {
+      Keep(node);
+      return;
+    }
+    SetNode(arena_->Create<lldb_eval::UnaryOpNode>(op, rhs.node));
+  }
+
+  void Visit(const lldb_eval::TernaryOpNode* node) override {
+    Folded cond = Fold(node->cond());
+
+    // Only the selected branch is evaluated, the result is the branch itself.
+    if (cond.is_constant) {
+      result_ = Fold(cond.value.AsBool() ? node->lhs() : node->rhs());
+      return;
+    }
+
+    Folded lhs = Fold(node->lhs());
+    Folded rhs = Fold(node->rhs());
+    if (cond.node == node->cond() && lhs.node == node->lhs() &&
+        rhs.node == node->rhs()) {
+      Keep(node);
+      return;
+    }
+    SetNode(arena_->Create<lldb_eval::TernaryOpNode>(cond.node, lhs.node,
+                                                     rhs.node));
+  }
+
+ private:
+  // Folds the operation on two constants the same way as
+  // `Interpreter::Visit(const BinaryOpNode*)` evaluates it. Returns false if
+  // the operation can't be folded.
+  bool FoldBinaryOp(clang::tok::TokenKind op, const Folded& lhs,
+                    const Folded& rhs) {
+    const Scalar& a = lhs.value;
+    const Scalar& b = rhs.value;
+
+    switch (op) {
+      case clang::tok::ampamp:
+      case clang::tok::pipepipe:
+        // The left operand didn't decide the result.
+        SetBoolean(b.AsBool());
+        return true;
+
+      case clang::tok::equalequal:
+        SetBoolean(a == b);
+        return true;
+      case clang::tok::exclaimequal:
+        SetBoolean(a != b);
+        return true;
+      case clang::tok::less:
+        SetBoolean(a < b);
+        return true;
+      case clang::tok::lessequal:
+        SetBoolean(a <= b);
+        return true;
+      case clang::tok::greater:
+        SetBoolean(a > b);
+        return true;
+      case clang::tok::greaterequal:
+        SetBoolean(a >= b);
+        return true;
+
+      case clang::tok::plus:
+        return SetScalar(a + b);
+      case clang::tok::minus:
+        return SetScalar(a - b);
+      case clang::tok::star:
+        return SetScalar(a * b);
+      case clang::tok::pipe:
+        return SetScalar(a | b);
+      case clang::tok::amp:
+        return SetScalar(a & b);
+      case clang::tok::caret:
+        return SetScalar(a ^ b);
+      case clang::tok::lessless:
+        return SetScalar(a << b);
+      case clang::tok::greatergreater:
+        return SetScalar(a >> b);
+
+      case clang::tok::slash:
+      case clang::tok::percent:
+        // Integer division by zero (or INT_MIN / -1) is undefined, leave it
+        // to the interpreter to report the error.
+        if (IsInteger(a) && IsInteger(b) &&
+            (b.GetInt64() == 0 || b.GetInt64() == -1)) {
+          return false;
+        }
+        return SetScalar(op == clang::tok::slash ? a / b : a % b);
+
+      default:
+        // E.g. subscript, which isn't valid for scalars.
+        return false;
+    }
+  }
+
+  void Keep(const AstNode* node) {
+    // The folder never modifies the nodes, the unchanged ones are shared with
+    // the folded tree.
+    SetNode(const_cast<AstNode*>(node));
+  }
+
+  void SetNode(ExprResult node) {
+    result_.node = node;
+    result_.is_constant = false;
+    result_.value = Scalar();
+  }
+
+  void SetBoolean(bool value) {
+    SetNode(arena_->Create<lldb_eval::BooleanLiteralNode>(value));
+    result_.is_constant = true;
+    result_.value = Scalar(static_cast<int32_t>(value));
+  }
+
+  bool SetScalar(const Scalar& value) {
+    // The operation isn't supported for the operand types (e.g. "1.5 & 1").
+    if (value.type_ == Scalar::Type::INVALID) {
+      return false;
+    }
+    SetNode(arena_->Create<lldb_eval::NumericLiteralNode>(value));
+    result_.is_constant = true;
+    result_.value = value;
+    return true;
+  }
+
+ private:
+  AstArena* arena_;
+  Folded result_;
+};
+
+}  // namespace
+
+namespace lldb_eval {
+
+ExprResult FoldConstants(AstArena& arena, ExprResult tree) {
+  ConstantFolder folder(arena);
+  return folder.Fold(tree).node;
+}
+
+}  // namespace lldb_eval
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_CONSTANT_FOLDING_H_
+#define LLDB_EVAL_CONSTANT_FOLDING_H_
+
+#include "ast.h"
+
+namespace lldb_eval {
+
+// Replaces the subtrees which don't depend on the debuggee (e.g.
+// "(1 << 12) - 1" or "true ? 1 : x") with literals, so they are not evaluated
+// over and over again. The folded values are computed exactly like the
+// interpreter would do it. Subtrees which would fail to evaluate are left as
+// they are, so the error is reported by the interpreter.
+//
+// New nodes are allocated in `arena`, the unchanged subtrees are shared with
+// the original tree. Returns the root of the folded tree.
+ExprResult FoldConstants(AstArena& arena, ExprResult tree);
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_CONSTANT_FOLDING_H_
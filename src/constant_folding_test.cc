@@ -0,0 +1,192 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "constant_folding.h"
+
+#include <string>
+
+#include "ast.h"
+#include "clang/Basic/TokenKinds.h"
+#include "expression_context.h"
+#include "lldb/API/SBExecutionContext.h"
+#include "parser.h"
+#include "scalar.h"
+
+// DISALLOW_COPY_AND_ASSIGN is also defined in
+// lldb/lldb-defines.h
+#undef DISALLOW_COPY_AND_ASSIGN
+#include "gtest/gtest.h"
+
+namespace {
+
+// Prints the AST back as an expression. Every operation is wrapped in
+// parentheses and the numeric literals have a suffix of their type, so the
+// result shows what exactly has been folded.
+class AstPrinter : lldb_eval::Visitor {
+ public:
+  std::string Print(const lldb_eval::AstNode* node) {
+    node->Accept(this);
+    return result_;
+  }
+
+ private:
+  void Visit(const lldb_eval::ErrorNode*) override { result_ = "<error>"; }
+
+  void Visit(const lldb_eval::BooleanLiteralNode* node) override {
+    result_ = node->value() ? "true" : "false";
+  }
+
+  void Visit(const lldb_eval::NumericLiteralNode* node) override {
+    lldb_eval::Scalar value = node->value();
+    switch (value.type_) {
+      case lldb_eval::Scalar::Type::INVALID:
+        result_ = "<invalid>";
+        break;
+      case lldb_eval::Scalar::Type::INT32:
+        result_ = std::to_string(value.value_.int32_);
+        break;
+      case lldb_eval::Scalar::Type::UINT32:
+        result_ = std::to_string(value.value_.uint32_) + "u";
+        break;
+      case lldb_eval::Scalar::Type::INT64:
+        result_ = std::to_string(value.value_.int64_) + "ll";
+        break;
+      case lldb_eval::Scalar::Type::UINT64:
+        result_ = std::to_string(value.value_.uint64_) + "ull";
+        break;
+      case lldb_eval::Scalar::Type::FLOAT:
+        result_ = std::to_string(value.value_.float_) + "f";
+        break;
+      case lldb_eval::Scalar::Type::DOUBLE:
+        result_ = std::to_string(value.value_.double_);
+        break;
+    }
+  }
+
+  void Visit(const lldb_eval::IdentifierNode* node) override {
+    result_ = node->name().str();
+  }
+
+  void Visit(const lldb_eval::CStyleCastNode* node) override {
+    result_ = "(" + node->type_decl().GetName() + ")" + Print(node->rhs());
+  }
+
+  void Visit(const lldb_eval::MemberOfNode* node) override {
+    bool of_pointer =
+        node->type() == lldb_eval::MemberOfNode::Type::OF_POINTER;
+    result_ = Print(node->lhs()) + (of_pointer ? "->" : ".") +
+              node->member_id()->name().str();
+  }
+
+  void Visit(const lldb_eval::BinaryOpNode* node) override {
+    std::string lhs = Print(node->lhs());
+    std::string rhs = Print(node->rhs());
+    if (node->op() == clang::tok::l_square) {
+      result_ = lhs + "[" + rhs + "]";
+      return;
+    }
+    result_ = "(" + lhs + " " + clang::tok::getPunctuatorSpelling(node->op()) +
+              " " + rhs + ")";
+  }
+
+  void Visit(const lldb_eval::UnaryOpNode* node) override {
+    result_ = "(" + std::string(clang::tok::getPunctuatorSpelling(node->op())) +
+              Print(node->rhs()) + ")";
+  }
+
+  void Visit(const lldb_eval::TernaryOpNode* node) override {
+    std::string cond = Print(node->cond());
+    std::string lhs = Print(node->lhs());
+    std::string rhs = Print(node->rhs());
+    result_ = "(" + cond + " ? " + lhs + " : " + rhs + ")";
+  }
+
+ private:
+  std::string result_;
+};
+
+// Returns the folded tree of `expr` printed. These tests check what is folded,
+// the values of the folded trees are compared with the interpreter by
+// TestConstantFolding in eval_test.cc.
+std::string Fold(const std::string& expr) {
+  // The expressions don't need the target, as long as they don't contain user
+  // defined types.
+  lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext());
+  lldb_eval::Parser parser(expr_ctx);
+  lldb_eval::ExprResult tree = parser.Run();
+  if (parser.HasError()) {
+    return parser.GetError();
+  }
+  tree = lldb_eval::FoldConstants(expr_ctx.GetAstArena(), tree);
+  return AstPrinter().Print(tree);
+}
+
+TEST(ConstantFoldingTest, TestArithmetic) {
+  EXPECT_EQ(Fold("(1 << 12) - 1"), "4095");
+  EXPECT_EQ(Fold("-(2 + 3)"), "-5");
+  EXPECT_EQ(Fold("+(7 % 4) * 2 ^ 1"), "7");
+  EXPECT_EQ(Fold("0xff & ~0"), "(255 & (~0))");
+  EXPECT_EQ(Fold("1.5 * 2"), "3.000000");
+}
+
+TEST(ConstantFoldingTest, TestPromotion) {
+  // The type of the result follows the usual arithmetic conversions.
+  EXPECT_EQ(Fold("1u - 2"), "4294967295u");
+  EXPECT_EQ(Fold("-20LL / 1U"), "-20ll");
+  EXPECT_EQ(Fold("1ULL << 40"), "1099511627776ull");
+  EXPECT_EQ(Fold("1.5f + 1"), "2.500000f");
+  // Booleans are promoted to int.
+  EXPECT_EQ(Fold("true + true"), "2");
+  EXPECT_EQ(Fold("+false"), "0");
+}
+
+TEST(ConstantFoldingTest, TestLogicalAndComparison) {
+  EXPECT_EQ(Fold("1 == 1.0"), "true");
+  EXPECT_EQ(Fold("2 < 1 || 3 >= 3"), "true");
+  EXPECT_EQ(Fold("1 && 0.0"), "false");
+  // The right operand isn't evaluated if the left one decides the result.
+  EXPECT_EQ(Fold("false && x"), "false");
+  EXPECT_EQ(Fold("1 || x"), "true");
+  EXPECT_EQ(Fold("true && x"), "(true && x)");
+  EXPECT_EQ(Fold("x && 1"), "(x && 1)");
+}
+
+TEST(ConstantFoldingTest, TestTernary) {
+  EXPECT_EQ(Fold("true ? 1 : x"), "1");
+  EXPECT_EQ(Fold("0 ? x : y + (1 + 1)"), "(y + 2)");
+  EXPECT_EQ(Fold("x ? 1 + 1 : 2 + 2"), "(x ? 2 : 4)");
+}
+
+TEST(ConstantFoldingTest, TestPartialFolding) {
+  EXPECT_EQ(Fold("a + 2 * 3"), "(a + 6)");
+  EXPECT_EQ(Fold("a + 2 + 3"), "((a + 2) + 3)");
+  EXPECT_EQ(Fold("arr[1 + 1]"), "arr[2]");
+  EXPECT_EQ(Fold("p->x + (1 << 2)"), "(p->x + 4)");
+  EXPECT_EQ(Fold("(char)(65 + 1)"), "(char)66");
+  EXPECT_EQ(Fold("*(p + (4 - 3))"), "(*(p + 1))");
+}
+
+TEST(ConstantFoldingTest, TestNotFolded) {
+  // Errors are reported by the interpreter.
+  EXPECT_EQ(Fold("1 / 0"), "(1 / 0)");
+  EXPECT_EQ(Fold("1 % 0"), "(1 % 0)");
+  EXPECT_EQ(Fold("1.5 & 1"), "(1.5 & 1)");
+  EXPECT_EQ(Fold("1[2]"), "1[2]");
+  EXPECT_EQ(Fold("*1"), "(*1)");
+  EXPECT_EQ(Fold("&1"), "(&1)");
+  // Floating point division by zero is fine.
+  EXPECT_EQ(Fold("1.0 / 0"), "inf");
+}
+
+}  // namespace
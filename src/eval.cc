@@ -14,14 +14,30 @@
 
 #include "eval.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "ast.h"
 #include "clang/Basic/TokenKinds.h"
+#include "frame_variables.h"
+#include "lldb/API/SBAddress.h"
+#include "lldb/API/SBTarget.h"
 #include "lldb/API/SBType.h"
 #include "lldb/API/SBValue.h"
+#include "lldb/lldb-defines.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "memory_cache.h"
+#include "pointer.h"
+#include "read_set.h"
+#include "scalar.h"
+#include "stats.h"
+#include "target_cache.h"
+#include "type_info.h"
 #include "value.h"
 
 namespace {
@@ -29,124 +45,285 @@ namespace {
 const char* kInvalidOperandsToBinaryExpression =
     "invalid operands to binary expression ('{0}' and '{1}')";
 
+bool IsIntegerScalar(const lldb_eval::Scalar& value) {
+  return value.type_ == lldb_eval::Scalar::Type::INT32 ||
+         value.type_ == lldb_eval::Scalar::Type::UINT32 ||
+         value.type_ == lldb_eval::Scalar::Type::INT64 ||
+         value.type_ == lldb_eval::Scalar::Type::UINT64;
+}
+
+lldb::SBValue FindGlobalVariable(lldb::SBTarget target,
+                                 const std::string& name) {
+  // TODO(werat): Implement scope-aware lookup. Relative scopes should be
+  // resolved relative to the current scope. I.e. if the current frame is in
+  // "ns1::ns2::Foo()", then "ns2::x" should resolve to "ns1::ns2::x".
+
+  // List global variable with the same "basename". There can be many matches
+  // from other scopes (namespaces, classes), so we do additional filtering
+  // later.
+  lldb::SBValueList values = target.FindGlobalVariables(
+      name.c_str(), /*max_matches=*/std::numeric_limits<uint32_t>::max());
+  if (lldb_eval::EvalStats* stats = lldb_eval::GetCurrentStats()) {
+    ++stats->find_global_variables_calls;
+  }
+
+  // Find the corrent variable by matching the name. lldb::SBValue::GetName()
+  // can return strings like "::globarVar", "ns::i" or "int const ns::foo"
+  // depending on the version and the platform.
+  for (uint32_t i = 0; i < values.GetSize(); ++i) {
+    lldb::SBValue val = values.GetValueAtIndex(i);
+    llvm::StringRef val_name = val.GetName();
+
+    if (val_name == name || val_name == "::" + name ||
+        val_name.endswith(" " + name)) {
+      return val;
+    }
+  }
+
+  return lldb::SBValue();
+}
+
+enum class MemberLookup {
+  FOUND,
+  NOT_FOUND,
+  // The member exists, but its location depends on the object.
+  NO_CONSTANT_OFFSET,
+};
+
+// Finds the member `name` of the record type the same way as
+// `SBValue::GetChildMemberWithName()`: among the fields first, including the
+// fields of anonymous structs and unions, then in the base classes. Bit-fields
+// and members of records with virtual bases have no constant byte offset.
+MemberLookup FindMemberOffset(lldb::SBType record, llvm::StringRef name,
+                              uint64_t* offset, lldb::SBType* type) {
+  if (record.GetNumberOfVirtualBaseClasses() > 0) {
+    return MemberLookup::NO_CONSTANT_OFFSET;
+  }
+
+  uint32_t num_fields = record.GetNumberOfFields();
+  for (uint32_t i = 0; i < num_fields; ++i) {
+    lldb::SBTypeMember field = record.GetFieldAtIndex(i);
+    llvm::StringRef field_name =
+        field.GetName() ? field.GetName() : llvm::StringRef();
+
+    if (field_name.empty()) {
+      uint64_t inner_offset;
+      MemberLookup lookup =
+          FindMemberOffset(field.GetType(), name, &inner_offset, type);
+      if (lookup == MemberLookup::FOUND) {
+        *offset = field.GetOffsetInBytes() + inner_offset;
+      }
+      if (lookup != MemberLookup::NOT_FOUND) {
+        return lookup;
+      }
+    } else if (field_name == name) {
+      if (field.IsBitfield()) {
+        return MemberLookup::NO_CONSTANT_OFFSET;
+      }
+      *offset = field.GetOffsetInBytes();
+      *type = field.GetType();
+      return MemberLookup::FOUND;
+    }
+  }
+
+  uint32_t num_bases = record.GetNumberOfDirectBaseClasses();
+  for (uint32_t i = 0; i < num_bases; ++i) {
+    lldb::SBTypeMember base = record.GetDirectBaseClassAtIndex(i);
+    uint64_t base_offset;
+    MemberLookup lookup =
+        FindMemberOffset(base.GetType(), name, &base_offset, type);
+    if (lookup == MemberLookup::FOUND) {
+      *offset = base.GetOffsetInBytes() + base_offset;
+    }
+    if (lookup != MemberLookup::NOT_FOUND) {
+      return lookup;
+    }
+  }
+
+  return MemberLookup::NOT_FOUND;
+}
+
+// Name of the type of the value, used in the error messages.
+std::string TypeName(const lldb_eval::Value& value, lldb::SBTarget target) {
+  const char* name = value.AsSbValue(target).GetTypeName();
+  return name ? name : "";
+}
+
 }  // namespace
 
 namespace lldb_eval {
 
-EvalError::EvalError() : code_(EvalErrorCode::OK) {}
+EvalError::EvalError()
+    : code_(EvalErrorCode::OK),
+      fmt_(nullptr),
+      num_args_(0),
+      type_args_(false) {}
 
 void EvalError::Set(EvalErrorCode code, const std::string& message) {
+  *this = {};
   code_ = code;
   message_ = message;
 }
 
+void EvalError::Set(EvalErrorCode code, const char* fmt,
+                    llvm::StringRef name) {
+  SetFormat(code, fmt, 1);
+  name_ = name;
+  type_args_ = false;
+}
+
+void EvalError::SetTypeError(const char* fmt, lldb::SBTarget target) {
+  SetFormat(EvalErrorCode::INVALID_OPERAND_TYPE, fmt, 0);
+  target_ = target;
+}
+
+void EvalError::SetTypeError(const char* fmt, lldb::SBTarget target,
+                             const Value& val) {
+  SetFormat(EvalErrorCode::INVALID_OPERAND_TYPE, fmt, 1);
+  target_ = target;
+  values_[0] = val;
+}
+
+void EvalError::SetTypeError(const char* fmt, lldb::SBTarget target,
+                             const Value& lhs, const Value& rhs) {
+  SetFormat(EvalErrorCode::INVALID_OPERAND_TYPE, fmt, 2);
+  target_ = target;
+  values_[0] = lhs;
+  values_[1] = rhs;
+}
+
+void EvalError::SetFormat(EvalErrorCode code, const char* fmt,
+                          size_t num_args) {
+  *this = {};
+  code_ = code;
+  fmt_ = fmt;
+  num_args_ = num_args;
+  type_args_ = true;
+}
+
 void EvalError::Clear() { *this = {}; }
 
 EvalErrorCode EvalError::code() const { return code_; }
-const std::string& EvalError::message() const { return message_; };
+
+const std::string& EvalError::message() const {
+  if (!fmt_ || !message_.empty()) {
+    return message_;
+  }
+
+  if (type_args_) {
+    std::string lhs_type = num_args_ > 0 ? TypeName(values_[0], target_) : "";
+    std::string rhs_type = num_args_ > 1 ? TypeName(values_[1], target_) : "";
+    switch (num_args_) {
+      case 0:
+        message_ = fmt_;
+        break;
+      case 1:
+        message_ = llvm::formatv(fmt_, lhs_type);
+        break;
+      default:
+        message_ = llvm::formatv(fmt_, lhs_type, rhs_type);
+        break;
+    }
+  } else {
+    message_ = llvm::formatv(fmt_, name_);
+  }
+  return message_;
+}
 
 EvalError::operator bool() const { return code_ != EvalErrorCode::OK; }
 
 Value Interpreter::Eval(const AstNode* tree, EvalError& error) {
+  // Read the target memory through a cache scoped to this evaluation, unless
+  // the caller provides one (e.g. for a batch of expressions).
+  MemoryCache memory_cache(target_.GetProcess());
+  MemoryCacheScope memory_cache_scope(
+      GetCurrentMemoryCache() ? GetCurrentMemoryCache() : &memory_cache);
+
+  // Same for the variables of the frame, the ones of the caller are used only
+  // if they belong to the frame of this evaluation.
+  FrameVariables frame_variables(frame_);
+  FrameVariables* current_variables = GetCurrentFrameVariables();
+  FrameVariablesScope frame_variables_scope(
+      current_variables && current_variables->frame().IsEqual(frame_)
+          ? current_variables
+          : &frame_variables);
+
+  // The types don't depend on the frame, a cache of any caller will do.
+  TypeInfoCache type_info_cache;
+  TypeInfoScope type_info_scope(GetCurrentTypeInfoCache()
+                                    ? GetCurrentTypeInfoCache()
+                                    : &type_info_cache);
+
   // Evaluate an AST.
-  EvalNode(tree);
+  Value result = EvalNode(tree);
   // Grab the error and reset the interpreter state.
   error = error_;
   error_.Clear();
   // Return the computed result. If there was an error, it will be invalid.
-  return result_;
+  return result;
 }
 
 Value Interpreter::EvalNode(const AstNode* node) {
-  // Traverse an AST pointed by the `node`.
-  node->Accept(this);
-  // If there was an error, reset the result.
-  if (error_) result_ = {};
-  // Return the computed value for convenience. The caller is responsible for
+  // Dispatch on the kind of the node rather than through `Accept()`, so the
+  // handlers of the nodes can be inlined.
+  Value result;
+  switch (node->kind()) {
+    case AstNode::Kind::INVALID:
+      result = EvalNode(static_cast<const ErrorNode*>(node));
+      break;
+    case AstNode::Kind::BOOLEAN_LITERAL:
+      result = EvalNode(static_cast<const BooleanLiteralNode*>(node));
+      break;
+    case AstNode::Kind::NUMERIC_LITERAL:
+      result = EvalNode(static_cast<const NumericLiteralNode*>(node));
+      break;
+    case AstNode::Kind::IDENTIFIER:
+      result = EvalNode(static_cast<const IdentifierNode*>(node));
+      break;
+    case AstNode::Kind::C_STYLE_CAST:
+      result = EvalNode(static_cast<const CStyleCastNode*>(node));
+      break;
+    case AstNode::Kind::MEMBER_OF:
+      result = EvalNode(static_cast<const MemberOfNode*>(node));
+      break;
+    case AstNode::Kind::BINARY_OP:
+      result = EvalNode(static_cast<const BinaryOpNode*>(node));
+      break;
+    case AstNode::Kind::UNARY_OP:
+      result = EvalNode(static_cast<const UnaryOpNode*>(node));
+      break;
+    case AstNode::Kind::TERNARY_OP:
+      result = EvalNode(static_cast<const TernaryOpNode*>(node));
+      break;
+  }
+  // If there was an error, reset the result. The caller is responsible for
   // checking if an error occured during the evaluation.
-  return result_;
+  if (error_) {
+    return Value();
+  }
+  return result;
 }
 
-void Interpreter::Visit(const ErrorNode*) {
+Value Interpreter::EvalNode(const ErrorNode*) {
   error_.Set(EvalErrorCode::UNKNOWN, "The AST is not valid.");
+  return Value();
 }
 
-void Interpreter::Visit(const BooleanLiteralNode* node) {
-  result_ = Value(node->value());
+Value Interpreter::EvalNode(const BooleanLiteralNode* node) {
+  return Value(node->value());
 }
 
-void Interpreter::Visit(const NumericLiteralNode* node) {
-  result_ = Value(node->value());
+Value Interpreter::EvalNode(const NumericLiteralNode* node) {
+  return Value(node->value());
 }
 
-void Interpreter::Visit(const IdentifierNode* node) {
-  // Internally values don't have global scope qualifier in their names and
-  // LLDB doesn't support queries with it too.
-  std::string name = node->name();
-  bool global_scope = false;
-
-  if (name.rfind("::", 0) == 0) {
-    name = name.substr(2);
-    global_scope = true;
-  }
-
-  lldb::SBValue value;
-
-  // If the identifier doesn't refer to the global scope and doesn't have any
-  // other scope qualifiers, try looking among the local and instance variables.
-  if (!global_scope && name.find("::") == std::string::npos) {
-    // Try looking for a local variable in current scope.
-    if (!value) {
-      value = frame_.FindVariable(name.c_str());
-    }
-    // Try looking for an instance variable (class member).
-    if (!value) {
-      value = frame_.FindVariable("this").GetChildMemberWithName(name.c_str());
-    }
-  }
-
-  // Try looking for a global or static variable.
-  if (!value) {
-    // TODO(werat): Implement scope-aware lookup. Relative scopes should be
-    // resolved relative to the current scope. I.e. if the current frame is in
-    // "ns1::ns2::Foo()", then "ns2::x" should resolve to "ns1::ns2::x".
-
-    // List global variable with the same "basename". There can be many matches
-    // from other scopes (namespaces, classes), so we do additional filtering
-    // later.
-    lldb::SBValueList values = target_.FindGlobalVariables(
-        name.c_str(), /*max_matches=*/std::numeric_limits<uint32_t>::max());
-
-    // Find the corrent variable by matching the name. lldb::SBValue::GetName()
-    // can return strings like "::globarVar", "ns::i" or "int const ns::foo"
-    // depending on the version and the platform.
-    for (uint32_t i = 0; i < values.GetSize(); ++i) {
-      lldb::SBValue val = values.GetValueAtIndex(i);
-      llvm::StringRef val_name = val.GetName();
-
-      if (val_name == name || val_name == "::" + name ||
-          val_name.endswith(" " + name)) {
-        value = val;
-        break;
-      }
-    }
-  }
-
-  if (!value) {
-    std::string msg = "use of undeclared identifier '" + node->name() + "'";
-    error_.Set(EvalErrorCode::UNDECLARED_IDENTIFIER, msg);
-    return;
-  }
-
-  // Special case for "this" pointer. As per C++ standard, it's a prvalue.
-  bool is_rvalue = node->name() == "this";
-
-  result_ = Value(value, is_rvalue);
+Value Interpreter::EvalNode(const IdentifierNode* node) {
+  return EvaluateIdentifier(node);
 }
 
-void Interpreter::Visit(const CStyleCastNode* node) {
+Value Interpreter::EvalNode(const CStyleCastNode* node) {
   // Resolve the type from the type declaration.
-  TypeDeclaration type_decl = node->type_decl();
+  const TypeDeclaration& type_decl = node->type_decl();
 
   // Resolve the type within the current expression context.
   lldb::SBType type =
@@ -157,7 +334,7 @@ void Interpreter::Visit(const CStyleCastNode* node) {
     std::string msg =
         "use of undeclared identifier '" + type_decl.GetBaseName() + "'";
     error_.Set(EvalErrorCode::UNDECLARED_IDENTIFIER, msg);
-    return;
+    return Value();
   }
 
   // Resolve pointers/references.
@@ -169,7 +346,7 @@ void Interpreter::Visit(const CStyleCastNode* node) {
             "'type name' declared as a pointer to a reference of type '{0}'",
             type.GetName());
         error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
-        return;
+        return Value();
       }
       // Get pointer type for the base type: e.g. int* -> int**.
       type = type.GetPointerType();
@@ -179,7 +356,7 @@ void Interpreter::Visit(const CStyleCastNode* node) {
       if (type.IsReferenceType()) {
         std::string msg = "type name declared as a reference to a reference";
         error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
-        return;
+        return Value();
       }
       // Get reference type for the base type: e.g. int -> int&.
       type = type.GetReferenceType();
@@ -189,23 +366,24 @@ void Interpreter::Visit(const CStyleCastNode* node) {
   // At this point we need to know the type of the value we're going to cast.
   auto rhs = EvalNode(node->rhs());
   if (!rhs) {
-    return;
+    return Value();
   }
 
   // Cast to basic type (integer/float).
-  if (type.GetCanonicalType().GetTypeFlags() & lldb::eTypeIsScalar) {
+  TypeInfo type_info = GetTypeInfo(type);
+  if (type_info.flags & lldb::eTypeIsScalar) {
     // Cast result
     Value value;
 
     // Pointers can be cast to integers of the same or larger size.
     if (rhs.IsPointer()) {
       // C-style cast from pointer to float/double is not allowed.
-      if (type.GetCanonicalType().GetTypeFlags() & lldb::eTypeIsFloat) {
-        std::string type_name = type.GetName();
+      if (type_info.flags & lldb::eTypeIsFloat) {
         std::string msg =
-            "C-style cast from '{0}' to '" + type_name + "' is not allowed";
-        ReportTypeError(msg.c_str(), rhs);
-        return;
+            llvm::formatv("C-style cast from '{0}' to '{1}' is not allowed",
+                          TypeName(rhs, target_), type.GetName());
+        error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
+        return Value();
       }
 
       // Check if the result type is at least as big as the pointer size.
@@ -213,8 +391,8 @@ void Interpreter::Visit(const CStyleCastNode* node) {
         std::string msg = llvm::formatv(
             "cast from pointer to smaller type '{0}' loses information",
             type.GetName());
-        ReportTypeError(msg.c_str());
-        return;
+        error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
+        return Value();
       }
 
       value = CastPointerToBasicType(rhs.AsPointer(), type, target_);
@@ -223,11 +401,11 @@ void Interpreter::Visit(const CStyleCastNode* node) {
       value = CastScalarToBasicType(rhs.AsScalar(), type, target_);
 
     } else {
-      std::string type_name = type.GetName();
-      std::string msg = "cannot convert '{0}' to '" + type_name +
-                        "' without a conversion operator";
-      ReportTypeError(msg.c_str(), rhs);
-      return;
+      std::string msg = llvm::formatv(
+          "cannot convert '{0}' to '{1}' without a conversion operator",
+          TypeName(rhs, target_), type.GetName());
+      error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
+      return Value();
     }
 
     if (!value.IsValid()) {
@@ -238,139 +416,284 @@ void Interpreter::Visit(const CStyleCastNode* node) {
       // make it unknown for now.
       // TODO(werat): Make sure there are not false-negative errors.
       error_.Set(EvalErrorCode::UNKNOWN, msg);
-      return;
+      return Value();
     }
 
-    result_ = value;
-    return;
+    return value;
   }
 
   // Cast to pointer type.
-  if (type.IsPointerType()) {
+  if (type_info.is_pointer) {
     // TODO(b/161677840): Implement type compatibility checks.
     // TODO(b/161677840): Do some error handling here.
-    result_ = Value(rhs.AsSbValue(target_).Cast(type));
-    return;
+    return Value(rhs.AsSbValue(target_).Cast(type));
   }
 
   std::string msg =
       llvm::formatv("casting of '{0}' to '{1}' is not implemented yet",
                     rhs.AsSbValue(target_).GetTypeName(), type.GetName());
   error_.Set(EvalErrorCode::NOT_IMPLEMENTED, msg);
+  return Value();
 }
 
-void Interpreter::Visit(const MemberOfNode* node) {
+Value Interpreter::EvalNode(const MemberOfNode* node) {
   auto lhs = EvalNode(node->lhs());
   if (!lhs) {
-    return;
+    return Value();
   }
+  return EvaluateMemberOf(node, lhs);
+}
 
+Value Interpreter::EvalNode(const BinaryOpNode* node) {
+  // Short-circuit logical operators.
+  if (node->op() == clang::tok::ampamp || node->op() == clang::tok::pipepipe) {
+    auto lhs = EvalNode(node->lhs());
+    if (!lhs || !BoolConvertible(lhs)) {
+      return Value();
+    }
+
+    if (node->op() == clang::tok::ampamp) {
+      // Check if the left condition is false, then break out early.
+      if (!lhs.AsBool()) {
+        return Value(false);
+      }
+    } else {
+      // Check if the left condition is true, then break out early.
+      if (lhs.AsBool()) {
+        return Value(true);
+      }
+    }
+
+    auto rhs = EvalNode(node->rhs());
+    if (!rhs || !BoolConvertible(rhs)) {
+      return Value();
+    }
+    return Value(rhs.AsBool());
+  }
+
+  // All other binary operations require evaluating both operands.
+  auto lhs = EvalNode(node->lhs());
+  if (!lhs) {
+    return Value();
+  }
+  auto rhs = EvalNode(node->rhs());
+  if (!rhs) {
+    return Value();
+  }
+
+  return EvaluateBinaryOp(node->op(), lhs, rhs);
+}
+
+Value Interpreter::EvalNode(const UnaryOpNode* node) {
+  auto rhs = EvalNode(node->rhs());
+  if (!rhs) {
+    return Value();
+  }
+  return EvaluateUnaryOp(node->op(), rhs);
+}
+
+Value Interpreter::EvalNode(const TernaryOpNode* node) {
+  auto cond = EvalNode(node->cond());
+  if (!cond || !BoolConvertible(cond)) {
+    return Value();
+  }
+
+  return cond.AsBool() ? EvalNode(node->lhs()) : EvalNode(node->rhs());
+}
+
+Value Interpreter::EvaluateIdentifier(const IdentifierNode* node) {
+  lldb::SBValue value = LookupIdentifier(node->name());
+  // The resolution depends on the frame, the incremental evaluation needs to
+  // check it again on the next stop.
+  TrackVariable(node->name(), value);
+
+  if (!value) {
+    error_.Set(EvalErrorCode::UNDECLARED_IDENTIFIER,
+               "use of undeclared identifier '{0}'", node->name());
+    return Value();
+  }
+
+  // Special case for "this" pointer. As per C++ standard, it's a prvalue.
+  bool is_rvalue = node->name() == "this";
+
+  return Value(value, is_rvalue);
+}
+
+lldb::SBValue Interpreter::LookupIdentifier(llvm::StringRef identifier) {
+  // Internally values don't have global scope qualifier in their names and
+  // LLDB doesn't support queries with it too.
+  std::string name = identifier.str();
+  bool global_scope = false;
+
+  if (name.rfind("::", 0) == 0) {
+    name = name.substr(2);
+    global_scope = true;
+  }
+
+  lldb::SBValue value;
+
+  // If the identifier doesn't refer to the global scope and doesn't have any
+  // other scope qualifiers, try looking among the local and instance variables.
+  if (!global_scope && name.find("::") == std::string::npos) {
+    // The evaluation shares the lookups with the other expressions evaluated
+    // in the same frame, see `Eval()`.
+    FrameVariables* variables = GetCurrentFrameVariables();
+    if (variables) {
+      value = variables->Find(name);
+    } else {
+      value = FrameVariables(frame_).Find(name);
+    }
+  }
+
+  // Try looking for a global or static variable. The lookup is expensive, so
+  // the results (including the negative ones) are cached per target.
+  if (!value) {
+    if (!target_cache_ || !target_cache_->LookupGlobalVariable(name, &value)) {
+      value = FindGlobalVariable(target_, name);
+      if (target_cache_) {
+        target_cache_->InsertGlobalVariable(name, value);
+      }
+    }
+  }
+
+  return value;
+}
+
+Value Interpreter::EvaluateMemberOf(const MemberOfNode* node, Value& lhs) {
   lldb::SBValue lhs_val = lhs.AsSbValue(target_);
+  lldb::SBType lhs_type = lhs_val.GetType();
+  TypeInfo lhs_info = GetTypeInfo(lhs_type);
+  bool of_pointer = node->type() == MemberOfNode::Type::OF_POINTER;
 
   switch (node->type()) {
     case MemberOfNode::Type::OF_OBJECT:
       // "member of object" operator, check that LHS is an object.
-      if (lhs_val.GetType().IsPointerType()) {
+      if (lhs_info.is_pointer) {
         ReportTypeError(
             "member reference type '{0}' is a pointer; "
             "did you mean to use '->'?",
             lhs);
-        return;
+        return Value();
       }
       break;
 
     case MemberOfNode::Type::OF_POINTER:
-      // "member of pointer" operator, check that LHS is a pointer and
-      // dereference it.
-      if (!lhs_val.GetType().IsPointerType()) {
+      // "member of pointer" operator, check that LHS is a pointer.
+      if (!lhs_info.is_pointer) {
         ReportTypeError(
             "member reference type '{0}' is not a pointer; "
             "did you mean to use '.'?",
             lhs);
-        return;
+        return Value();
       }
-      lhs_val = lhs_val.Dereference();
+      TrackRead(lhs_val);
       break;
   }
 
   // Check if LHS is a record type, i.e. class/struct or union.
-  if (!(lhs_val.GetType().GetDereferencedType().GetTypeClass() &
+  lldb::SBType record_type =
+      of_pointer ? lhs_type.GetPointeeType() : lhs_type.GetDereferencedType();
+  if (!(record_type.GetTypeClass() &
         (lldb::eTypeClassClass | lldb::eTypeClassStruct |
          lldb::eTypeClassUnion))) {
     ReportTypeError(
         "member reference base type '{0}' is not a structure or union", lhs);
-    return;
+    return Value();
+  }
+
+  llvm::StringRef name = node->member_id()->name();
+  lldb::SBValue member_val;
+
+  // Members at a constant offset are created directly at their address, so
+  // the layout of the record is walked only once per target. Dynamic values
+  // and references are left to LLDB, their address isn't the one of the
+  // record.
+  if (!lhs_val.IsDynamic() && !lhs_info.is_reference) {
+    TargetCache::MemberLocation member;
+    if (!target_cache_ || !target_cache_->LookupMember(record_type, name,
+                                                       &member)) {
+      member.has_offset = FindMemberOffset(record_type, name, &member.offset,
+                                           &member.type) == MemberLookup::FOUND;
+      if (target_cache_) {
+        target_cache_->InsertMember(record_type, name, member);
+      }
+    }
+
+    lldb::addr_t record_addr = LLDB_INVALID_ADDRESS;
+    if (member.has_offset) {
+      record_addr = of_pointer ? Pointer::FromSbValue(lhs_val).addr()
+                               : lhs_val.GetLoadAddress();
+    }
+    if (record_addr != LLDB_INVALID_ADDRESS) {
+      member_val = target_.CreateValueFromAddress(
+          name.str().c_str(),
+          lldb::SBAddress(record_addr + member.offset, target_), member.type);
+    }
   }
 
-  lldb::SBValue member_val =
-      lhs_val.GetChildMemberWithName(node->member_id()->name().c_str());
+  if (!member_val) {
+    if (of_pointer) {
+      lhs_val = lhs_val.Dereference();
+    }
+    member_val = lhs_val.GetChildMemberWithName(name.str().c_str());
+  }
 
   if (!member_val) {
-    auto msg = llvm::formatv("no member named '{0}' in '{1}'",
-                             node->member_id()->name(),
+    auto msg = llvm::formatv("no member named '{0}' in '{1}'", name,
                              lhs_val.GetType().GetUnqualifiedType().GetName());
     error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
-    return;
+    return Value();
   }
 
-  result_ = Value(member_val);
+  return Value(member_val);
 }
 
-void Interpreter::Visit(const BinaryOpNode* node) {
-  // Short-circuit logical operators.
-  if (node->op() == clang::tok::ampamp || node->op() == clang::tok::pipepipe) {
-    auto lhs = EvalNode(node->lhs());
-    if (!lhs || !BoolConvertible(lhs)) {
-      return;
-    }
-
-    if (node->op() == clang::tok::ampamp) {
-      // Check if the left condition is false, then break out early.
-      if (!lhs.AsBool()) {
-        result_ = Value(false);
-        return;
-      }
-    } else {
-      // Check if the left condition is true, then break out early.
-      if (lhs.AsBool()) {
-        result_ = Value(true);
-        return;
-      }
-    }
+bool Interpreter::CheckIntegerDivision(clang::tok::TokenKind op,
+                                       const Scalar& lhs, const Scalar& rhs) {
+  if (!IsIntegerScalar(lhs) || !IsIntegerScalar(rhs)) {
+    return true;
+  }
 
-    auto rhs = EvalNode(node->rhs());
-    if (!rhs || !BoolConvertible(rhs)) {
-      return;
-    }
-    result_ = Value(rhs.AsBool());
-    return;
+  if (rhs.GetInt64() == 0) {
+    error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE,
+               op == clang::tok::slash ? "division by zero is undefined"
+                                       : "remainder by zero is undefined");
+    return false;
   }
 
-  // All other binary operations require evaluating both operands.
-  auto lhs = EvalNode(node->lhs());
-  if (!lhs) {
-    return;
+  // The operands are converted to the type with the higher rank, the result
+  // overflows only if it's signed.
+  Scalar::Type type = std::max(lhs.type_, rhs.type_);
+  bool overflow = false;
+  if (type == Scalar::Type::INT32) {
+    overflow = lhs.value_.int32_ == std::numeric_limits<int32_t>::min() &&
+               rhs.value_.int32_ == -1;
+  } else if (type == Scalar::Type::INT64) {
+    overflow = lhs.GetInt64() == std::numeric_limits<int64_t>::min() &&
+               rhs.GetInt64() == -1;
   }
-  auto rhs = EvalNode(node->rhs());
-  if (!rhs) {
-    return;
+  if (overflow) {
+    error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE,
+               "overflow in expression; the result is not representable");
+    return false;
   }
+  return true;
+}
 
-  switch (node->op()) {
+Value Interpreter::EvaluateBinaryOp(clang::tok::TokenKind op, Value& lhs,
+                                    Value& rhs) {
+  switch (op) {
     // "l_square" is a subscript operator -- array[index].
     case clang::tok::l_square:
-      result_ = EvaluateSubscript(lhs, rhs);
-      return;
+      return EvaluateSubscript(lhs, rhs);
 
     // Binary addition.
     case clang::tok::plus:
-      result_ = EvaluateAddition(lhs, rhs);
-      return;
+      return EvaluateAddition(lhs, rhs);
 
     // Binary subtraction.
     case clang::tok::minus:
-      result_ = EvaluateSubtraction(lhs, rhs);
-      return;
+      return EvaluateSubtraction(lhs, rhs);
 
     // Comparison operations.
     case clang::tok::equalequal:
@@ -379,8 +702,7 @@ void Interpreter::Visit(const BinaryOpNode* node) {
     case clang::tok::lessequal:
     case clang::tok::greater:
     case clang::tok::greaterequal:
-      result_ = EvaluateComparison(lhs, rhs, node->op());
-      return;
+      return EvaluateComparison(lhs, rhs, op);
 
     default:
       break;
@@ -389,121 +711,101 @@ void Interpreter::Visit(const BinaryOpNode* node) {
   // Everything else works only for scalar values.
   if (!lhs.IsScalar() || !rhs.IsScalar()) {
     ReportTypeError(kInvalidOperandsToBinaryExpression, lhs, rhs);
-    return;
+    return Value();
   }
 
   auto lhs_scalar = lhs.AsScalar();
   auto rhs_scalar = rhs.AsScalar();
 
-  switch (node->op()) {
+  // Integer division by zero and the division of the minimal value by -1 trap
+  // on the host.
+  if ((op == clang::tok::slash || op == clang::tok::percent) &&
+      !CheckIntegerDivision(op, lhs_scalar, rhs_scalar)) {
+    return Value();
+  }
+
+  switch (op) {
     case clang::tok::slash:
-      result_ = Value(lhs_scalar / rhs_scalar);
-      break;
+      return Value(lhs_scalar / rhs_scalar);
     case clang::tok::star:
-      result_ = Value(lhs_scalar * rhs_scalar);
-      break;
+      return Value(lhs_scalar * rhs_scalar);
     case clang::tok::pipe:
-      result_ = Value(lhs_scalar | rhs_scalar);
-      break;
+      return Value(lhs_scalar | rhs_scalar);
     case clang::tok::amp:
-      result_ = Value(lhs_scalar & rhs_scalar);
-      break;
+      return Value(lhs_scalar & rhs_scalar);
     case clang::tok::percent:
-      result_ = Value(lhs_scalar % rhs_scalar);
-      break;
+      return Value(lhs_scalar % rhs_scalar);
     case clang::tok::caret:
-      result_ = Value(lhs_scalar ^ rhs_scalar);
-      break;
+      return Value(lhs_scalar ^ rhs_scalar);
     case clang::tok::lessless:
-      result_ = Value(lhs_scalar << rhs_scalar);
-      break;
+      return Value(lhs_scalar << rhs_scalar);
     case clang::tok::greatergreater:
-      result_ = Value(lhs_scalar >> rhs_scalar);
-      break;
+      return Value(lhs_scalar >> rhs_scalar);
 
     default: {
-      std::string msg = "Unexpected op: " + node->op_name();
+      std::string msg =
+          "Unexpected op: " + std::string(clang::tok::getTokenName(op));
       error_.Set(EvalErrorCode::UNKNOWN, msg);
-      return;
+      return Value();
     }
   }
 }
 
-void Interpreter::Visit(const UnaryOpNode* node) {
-  auto rhs = EvalNode(node->rhs());
-  if (!rhs) {
-    return;
-  }
-
+Value Interpreter::EvaluateUnaryOp(clang::tok::TokenKind op, Value& rhs) {
   // TODO(werat): Should dereference be a separate AST node?
-  if (node->op() == clang::tok::star) {
+  if (op == clang::tok::star) {
     lldb::SBValue rhs_val = rhs.AsSbValue(target_);
 
     if (!rhs.IsPointer()) {
       // TODO(werat): Add literal value to the error message.
       ReportTypeError("indirection requires pointer operand. ('{0}' invalid)",
                       rhs);
-      return;
+      return Value();
     }
 
-    result_ = Value(rhs_val.Dereference());
-    return;
+    TrackRead(rhs_val);
+    return Value(rhs_val.Dereference());
   }
 
   // Address-of operator.
-  if (node->op() == clang::tok::amp) {
+  if (op == clang::tok::amp) {
     lldb::SBValue rhs_val = rhs.AsSbValue(target_);
 
     if (rhs.IsRValue()) {
       ReportTypeError("cannot take the address of an rvalue of type '{0}'",
                       rhs);
-      return;
+      return Value();
     }
 
-    result_ = Value(rhs_val.AddressOf(), /* is_rvalue */ true);
-    return;
+    return Value(rhs_val.AddressOf(), /* is_rvalue */ true);
   }
 
   // Unary plus.
-  if (node->op() == clang::tok::plus) {
+  if (op == clang::tok::plus) {
     if (rhs.IsPointer()) {
-      result_ = Value(rhs.AsPointer());
-      return;
+      return Value(rhs.AsPointer());
     }
     if (rhs.IsScalar()) {
-      result_ = Value(rhs.AsScalar());
-      return;
+      return Value(rhs.AsScalar());
     }
   }
 
   // Unary minus.
-  if (node->op() == clang::tok::minus) {
+  if (op == clang::tok::minus) {
     if (rhs.IsPointer()) {
       ReportTypeError("invalid argument type '{0}' to unary expression", rhs);
-      return;
+      return Value();
     }
     if (rhs.IsScalar()) {
-      result_ = Value(rhs.AsScalar() * Scalar(-1));
-      return;
+      return Value(rhs.AsScalar() * Scalar(-1));
     }
   }
 
   // Unsupported/invalid operation.
-  std::string msg = "Unexpected op: " + node->op_name();
+  std::string msg =
+      "Unexpected op: " + std::string(clang::tok::getTokenName(op));
   error_.Set(EvalErrorCode::UNKNOWN, msg);
-}
-
-void Interpreter::Visit(const TernaryOpNode* node) {
-  auto cond = EvalNode(node->cond());
-  if (!cond || !BoolConvertible(cond)) {
-    return;
-  }
-
-  if (cond.AsBool()) {
-    result_ = EvalNode(node->lhs());
-  } else {
-    result_ = EvalNode(node->rhs());
-  }
+  return Value();
 }
 
 Value Interpreter::EvaluateSubscript(Value& lhs, Value& rhs) {
@@ -518,13 +820,13 @@ Value Interpreter::EvaluateSubscript(Value& lhs, Value& rhs) {
 
   // Both lhs and rhs can be references, but that's acceptable. Look at
   // underlying types.
-  lldb::SBType lhs_type = lhs_val.GetType().GetDereferencedType();
-  lldb::SBType rhs_type = rhs_val.GetType().GetDereferencedType();
+  TypeInfo lhs_info = GetTypeInfo(lhs_val.GetType().GetDereferencedType());
+  TypeInfo rhs_info = GetTypeInfo(rhs_val.GetType().GetDereferencedType());
 
-  if (lhs_type.IsArrayType() || lhs_type.IsPointerType()) {
+  if (lhs_info.is_array || lhs_info.is_pointer) {
     base = lhs_val;
     index = rhs_val;
-  } else if (rhs_type.IsArrayType() || rhs_type.IsPointerType()) {
+  } else if (rhs_info.is_array || rhs_info.is_pointer) {
     base = rhs_val;
     index = lhs_val;
   } else {
@@ -534,21 +836,22 @@ Value Interpreter::EvaluateSubscript(Value& lhs, Value& rhs) {
 
   // Base can be a reference type (e.g. "int (&)[]"). In this case we need to
   // dereference it, so we can get the underlying value.
-  if (base.GetType().IsReferenceType()) {
+  lldb::SBType base_type = base.GetType();
+  if (GetTypeInfo(base_type).is_reference) {
     base = base.Dereference();
+    base_type = base.GetType();
   }
   // Index can be a reference type too (e.g. "int&").
-  if (index.GetType().IsReferenceType()) {
+  if (GetTypeInfo(index.GetType()).is_reference) {
     index = index.Dereference();
   }
 
-  // Index can be a typedef of a typedef of a typedef of a typedef...
-  // Get canonical underlying type.
-  lldb::SBType index_type = index.GetType().GetCanonicalType();
+  // Index can be a typedef of a typedef of a typedef of a typedef... The basic
+  // type is the one of the canonical underlying type.
+  lldb::BasicType index_type = GetTypeInfo(index.GetType()).basic_type;
 
   // Check if the index is of an integral type.
-  if (index_type.GetBasicType() < lldb::eBasicTypeChar ||
-      index_type.GetBasicType() > lldb::eBasicTypeBool) {
+  if (index_type < lldb::eBasicTypeChar || index_type > lldb::eBasicTypeBool) {
     ReportTypeError("array subscript is not an integer");
     return Value();
   }
@@ -556,19 +859,27 @@ Value Interpreter::EvaluateSubscript(Value& lhs, Value& rhs) {
   lldb::SBType item_type;
   lldb::addr_t base_addr;
 
-  if (base.GetType().IsArrayType()) {
-    item_type = base.GetType().GetArrayElementType();
+  TypeInfo base_info = GetTypeInfo(base_type);
+  if (base_info.is_array) {
+    item_type = base_type.GetArrayElementType();
     base_addr = base.GetAddress().GetLoadAddress(target_);
-  } else if (base.GetType().IsPointerType()) {
-    item_type = base.GetType().GetPointeeType();
-    base_addr = static_cast<lldb::addr_t>(base.GetValueAsUnsigned());
+  } else if (base_info.is_pointer) {
+    item_type = base_type.GetPointeeType();
+    base_addr = Pointer::FromSbValue(base).addr();
   } else {
     unreachable("Subscripted value must be either array or pointer.");
   }
 
+  // Read the index through the memory cache if possible. Scalar doesn't
+  // support some integer types (e.g. __int128), let LLDB read them.
+  Scalar index_scalar = Scalar::FromSbValue(index);
+  int64_t index_value = index_scalar.type_ != Scalar::Type::INVALID
+                            ? index_scalar.GetInt64()
+                            : index.GetValueAsSigned();
+
   // Create a pointer and add the index, i.e. "base + index".
   auto pointer = Value(Pointer(base_addr, item_type.GetPointerType())
-                           .Add(index.GetValueAsSigned()));
+                           .Add(index_value));
   // Dereference the result, i.e. *(base + index).
   return Value(pointer.AsSbValue(target_).Dereference());
 }
@@ -640,8 +951,8 @@ Value Interpreter::EvaluateSubtraction(Value& lhs, Value& rhs) {
       return Value();
     }
 
-    auto lhs_type = lhs_pointer.type().GetCanonicalType().GetUnqualifiedType();
-    auto rhs_type = rhs_pointer.type().GetCanonicalType().GetUnqualifiedType();
+    auto lhs_type = GetTypeInfo(lhs_pointer.type()).canonical_unqualified;
+    auto rhs_type = GetTypeInfo(rhs_pointer.type()).canonical_unqualified;
 
     if (lhs_type != rhs_type) {
       ReportTypeError("'{0}' and '{1}' are not pointers to compatible types",
@@ -650,7 +961,7 @@ Value Interpreter::EvaluateSubtraction(Value& lhs, Value& rhs) {
     }
 
     // Since pointers have compatible types, both have the same pointee size.
-    uint64_t item_size = lhs_pointer.type().GetPointeeType().GetByteSize();
+    uint64_t item_size = GetTypeInfo(lhs_pointer.type()).pointee_size;
 
     // Pointer difference is technically ptrdiff_t, but the important part is
     // that it is signed.
@@ -700,10 +1011,8 @@ Value Interpreter::EvaluateComparison(Value& lhs, Value& rhs,
 
     // Comparing pointers to void is always allowed.
     if (!lhs_pointer.IsPointerToVoid() && !rhs_pointer.IsPointerToVoid()) {
-      auto lhs_type =
-          lhs_pointer.type().GetCanonicalType().GetUnqualifiedType();
-      auto rhs_type =
-          rhs_pointer.type().GetCanonicalType().GetUnqualifiedType();
+      auto lhs_type = GetTypeInfo(lhs_pointer.type()).canonical_unqualified;
+      auto rhs_type = GetTypeInfo(rhs_pointer.type()).canonical_unqualified;
 
       if (lhs_type != rhs_type) {
         ReportTypeError(
@@ -748,23 +1057,16 @@ bool Interpreter::BoolConvertible(Value& val) {
 }
 
 void Interpreter::ReportTypeError(const char* fmt) {
-  error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, fmt);
+  error_.SetTypeError(fmt, target_);
 }
 
 void Interpreter::ReportTypeError(const char* fmt, const Value& val) {
-  std::string rhs_type = val.AsSbValue(target_).GetTypeName();
-
-  auto msg = llvm::formatv(fmt, rhs_type);
-  error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
+  error_.SetTypeError(fmt, target_, val);
 }
 
 void Interpreter::ReportTypeError(const char* fmt, const Value& lhs,
                                   const Value& rhs) {
-  std::string lhs_type = lhs.AsSbValue(target_).GetTypeName();
-  std::string rhs_type = rhs.AsSbValue(target_).GetTypeName();
-
-  auto msg = llvm::formatv(fmt, lhs_type, rhs_type);
-  error_.Set(EvalErrorCode::INVALID_OPERAND_TYPE, msg);
+  error_.SetTypeError(fmt, target_, lhs, rhs);
 }
 
 }  // namespace lldb_eval
@@ -17,6 +17,10 @@
 #ifndef LLDB_EVAL_EVAL_H_
 #define LLDB_EVAL_EVAL_H_
 
+#include <cstddef>
+#include <memory>
+#include <string>
+
 #include "ast.h"
 #include "clang/Basic/TokenKinds.h"
 #include "defines.h"
@@ -26,6 +30,8 @@
 #include "lldb/API/SBTarget.h"
 #include "lldb/API/SBThread.h"
 #include "lldb/API/SBValue.h"
+#include "llvm/ADT/StringRef.h"
+#include "target_cache.h"
 #include "value.h"
 
 namespace lldb_eval {
@@ -39,11 +45,25 @@ enum class EvalErrorCode {
   UNKNOWN,
 };
 
+// Error of the evaluation. Most messages are formatted only when they're
+// requested, so the evaluations which only check the error code (e.g. of a
+// breakpoint condition) don't spend time and allocations on them. Such errors
+// refer to the values of the evaluation and to the names in the AST, so the
+// message must be requested while the expression is alive.
 class EvalError {
  public:
   EvalError();
 
   void Set(EvalErrorCode code, const std::string& message);
+  // The message is `llvm::formatv(fmt, name)`. The format string is expected
+  // to be a literal.
+  void Set(EvalErrorCode code, const char* fmt, llvm::StringRef name);
+  // Sets INVALID_OPERAND_TYPE error, the message is `llvm::formatv()` of the
+  // format string and the type names of the values (if any).
+  void SetTypeError(const char* fmt, lldb::SBTarget target);
+  void SetTypeError(const char* fmt, lldb::SBTarget target, const Value& val);
+  void SetTypeError(const char* fmt, lldb::SBTarget target, const Value& lhs,
+                    const Value& rhs);
   void Clear();
 
   EvalErrorCode code() const;
@@ -52,42 +72,79 @@ class EvalError {
   explicit operator bool() const;
 
  private:
+  void SetFormat(EvalErrorCode code, const char* fmt, size_t num_args);
+
   EvalErrorCode code_;
-  std::string message_;
+  // Format string of the message and its arguments, either a name or the
+  // values whose type names are substituted. The format string is null if
+  // the message is set directly.
+  const char* fmt_;
+  size_t num_args_;
+  bool type_args_;
+  llvm::StringRef name_;
+  lldb::SBTarget target_;
+  Value values_[2];
+  // The message, formatted on the first request.
+  mutable std::string message_;
 };
 
-class Interpreter : Visitor {
+class Interpreter {
  public:
-  explicit Interpreter(ExpressionContext& expr_ctx) : expr_ctx_(&expr_ctx) {
-    target_ = expr_ctx_->GetExecutionContext().GetTarget();
-    frame_ = expr_ctx_->GetExecutionContext().GetFrame();
+  explicit Interpreter(ExpressionContext& expr_ctx)
+      : Interpreter(expr_ctx, expr_ctx.GetExecutionContext()) {}
+
+  // Evaluate the expression in the given execution context instead of the one
+  // the expression was parsed in. This allows to parse the expression once and
+  // then evaluate it many times (e.g. in different frames).
+  Interpreter(ExpressionContext& expr_ctx, lldb::SBExecutionContext exec_ctx)
+      : expr_ctx_(&expr_ctx) {
+    target_ = exec_ctx.GetTarget();
+    frame_ = exec_ctx.GetFrame();
+    // Reuse the cache of the expression context if the target is the same.
+    target_cache_ = target_ == expr_ctx.GetExecutionContext().GetTarget()
+                        ? expr_ctx.GetTargetCache()
+                        : TargetCache::Get(target_);
   }
 
  public:
   Value Eval(const AstNode* tree, EvalError& error);
 
- private:
-  void Visit(const ErrorNode* node) override;
-
-  void Visit(const BooleanLiteralNode* node) override;
-
-  void Visit(const NumericLiteralNode* node) override;
-
-  void Visit(const IdentifierNode* node) override;
-
-  void Visit(const CStyleCastNode* node) override;
-
-  void Visit(const MemberOfNode* node) override;
-
-  void Visit(const BinaryOpNode* node) override;
-
-  void Visit(const UnaryOpNode* node) override;
-
-  void Visit(const TernaryOpNode* node) override;
+  // Returns the variable the identifier refers to in the current frame, the
+  // same way as it's resolved in the expressions. The returned value is not
+  // valid if there is no such variable. Locals and instance variables are
+  // resolved through the current `FrameVariables`, if there are any.
+  lldb::SBValue LookupIdentifier(llvm::StringRef identifier);
 
  private:
+  // The bytecode VM evaluates the operations with the helpers below, so both
+  // evaluators have the same semantics.
+  friend class VirtualMachine;
+
+  // Evaluates the node, dispatching on its kind. On error `error_` is set and
+  // the returned value is invalid.
   Value EvalNode(const AstNode* node);
 
+  Value EvalNode(const ErrorNode* node);
+  Value EvalNode(const BooleanLiteralNode* node);
+  Value EvalNode(const NumericLiteralNode* node);
+  Value EvalNode(const IdentifierNode* node);
+  Value EvalNode(const CStyleCastNode* node);
+  Value EvalNode(const MemberOfNode* node);
+  Value EvalNode(const BinaryOpNode* node);
+  Value EvalNode(const UnaryOpNode* node);
+  Value EvalNode(const TernaryOpNode* node);
+
+  // Evaluate a single operation on the already evaluated operands. On error
+  // `error_` is set and the returned value is invalid.
+  Value EvaluateIdentifier(const IdentifierNode* node);
+  Value EvaluateMemberOf(const MemberOfNode* node, Value& lhs);
+  Value EvaluateBinaryOp(clang::tok::TokenKind op, Value& lhs, Value& rhs);
+  // Reports an error and returns false if the integer division (or remainder)
+  // of the scalars is undefined.
+  bool CheckIntegerDivision(clang::tok::TokenKind op, const Scalar& lhs,
+                            const Scalar& rhs);
+  Value EvaluateUnaryOp(clang::tok::TokenKind op, Value& rhs);
+
   Value EvaluateSubscript(Value& lhs, Value& rhs);
   Value EvaluateAddition(Value& lhs, Value& rhs);
   Value EvaluateSubtraction(Value& lhs, Value& rhs);
@@ -95,7 +152,7 @@ class Interpreter : Visitor {
 
   bool BoolConvertible(Value& val);
 
-  void ReportTypeError(const char* fmr);
+  void ReportTypeError(const char* fmt);
   void ReportTypeError(const char* fmt, const Value& val);
   void ReportTypeError(const char* fmt, const Value& lhs, const Value& rhs);
 
@@ -109,7 +166,10 @@ class Interpreter : Visitor {
   lldb::SBTarget target_;
   lldb::SBFrame frame_;
 
-  Value result_;
+  // Lookup results shared with other expressions in the same target. Can be
+  // nullptr if there is no target.
+  std::shared_ptr<TargetCache> target_cache_;
+
   EvalError error_;
 };
 
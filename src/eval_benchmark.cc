@@ -0,0 +1,864 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "api.h"
+#include "benchmark/benchmark.h"
+#include "bytecode.h"
+#include "eval.h"
+#include "expression_context.h"
+#include "lldb/API/SBBreakpoint.h"
+#include "lldb/API/SBDebugger.h"
+#include "lldb/API/SBError.h"
+#include "lldb/API/SBExecutionContext.h"
+#include "lldb/API/SBFrame.h"
+#include "lldb/API/SBLineEntry.h"
+#include "lldb/API/SBProcess.h"
+#include "lldb/API/SBTarget.h"
+#include "lldb/API/SBThread.h"
+#include "lldb/API/SBValue.h"
+#include "parser.h"
+#include "runner.h"
+#include "tools/cpp/runfiles/runfiles.h"
+#include "type_info.h"
+#include "value.h"
+
+using bazel::tools::cpp::runfiles::Runfiles;
+
+// Count the heap allocations to measure how many of them the interpreter
+// performs per evaluation.
+static std::atomic<size_t> g_num_allocations(0);
+
+void* operator new(size_t size) {
+  ++g_num_allocations;
+  void* ptr = std::malloc(size);
+  if (!ptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+// Expression used for comparing different evaluation paths. It involves a type
+// lookup, a local variable lookup and some arithmetic.
+const char* kExpression = "(::ns::inner::mydouble)myint_ + a * 2";
+
+// Frame the expressions are evaluated in. Updated in main() every time the
+// test program stops at the next breakpoint.
+lldb::SBFrame frame;
+
+// Parse and evaluate the expression on every iteration.
+void BM_EvaluateExpression(benchmark::State& state) {
+  for (auto _ : state) {
+    lldb::SBError error;
+    lldb::SBValue value =
+        lldb_eval::EvaluateExpression(frame, kExpression, error);
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+// Parse the expression once and evaluate it on every iteration.
+void BM_EvaluateCompiledExpression(benchmark::State& state) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 kExpression, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  for (auto _ : state) {
+    lldb::SBValue value = expr.Evaluate(frame, error);
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+// Expressions a debugger would evaluate on every stop, e.g. to refresh the
+// watch window.
+const char* kWatchExpressions[] = {
+    "a",
+    "ap",
+    "*ap",
+    "na",
+    "f",
+    "myint_",
+    "ns_myint_",
+    "ns_inner_mydouble_",
+    "(int)f",
+    "(char)a",
+    "(long long)na",
+    "(float)myint_",
+    "(myint)ns_myint_",
+    "(ns::myint)a",
+    "a + na",
+    "a * 2 + ns_myint_",
+    "a ? f : na",
+    "ap + 1",
+    "&a",
+    kExpression,
+};
+const size_t kNumWatchExpressions =
+    sizeof(kWatchExpressions) / sizeof(kWatchExpressions[0]);
+
+// Evaluate the expressions one by one.
+void BM_EvaluateExpressionsLoop(benchmark::State& state) {
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumWatchExpressions; ++i) {
+      lldb::SBError error;
+      lldb::SBValue value =
+          lldb_eval::EvaluateExpression(frame, kWatchExpressions[i], error);
+      benchmark::DoNotOptimize(value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kNumWatchExpressions);
+}
+
+// Evaluate the same expressions as a single batch.
+void BM_EvaluateExpressionsBatch(benchmark::State& state) {
+  lldb::SBValue values[kNumWatchExpressions];
+  lldb::SBError errors[kNumWatchExpressions];
+
+  for (auto _ : state) {
+    lldb_eval::EvaluateExpressions(frame, kWatchExpressions,
+                                   kNumWatchExpressions, values, errors);
+    benchmark::DoNotOptimize(values);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumWatchExpressions);
+}
+
+// Local variables of the comparison site. The watch window of a debugger
+// usually shows a few expressions per variable, so the identifiers repeat.
+const char* kLocalVariables[] = {
+    "a",
+    "ap",
+    "vp",
+    "na",
+    "f",
+    "myint_",
+    "ns_myint_",
+    "ns_foo_",
+    "ns_foo_ptr_",
+    "ns_inner_mydouble_",
+    "ns_inner_foo_",
+    "ns_inner_foo_ptr_",
+};
+const size_t kNumIdentifierExpressions = 100;
+
+// Returns `kNumIdentifierExpressions` expressions, each of them a single
+// identifier.
+std::vector<const char*> MakeIdentifierExpressions() {
+  const size_t num_variables =
+      sizeof(kLocalVariables) / sizeof(kLocalVariables[0]);
+  std::vector<const char*> expressions(kNumIdentifierExpressions);
+  for (size_t i = 0; i < expressions.size(); ++i) {
+    expressions[i] = kLocalVariables[i % num_variables];
+  }
+  return expressions;
+}
+
+// Evaluate 100 identifiers in the same frame, either one by one or as a batch,
+// which resolves every name in the frame only once.
+void BM_EvaluateIdentifiers(benchmark::State& state, bool batch) {
+  std::vector<const char*> expressions = MakeIdentifierExpressions();
+  std::vector<lldb::SBValue> values(expressions.size());
+  std::vector<lldb::SBError> errors(expressions.size());
+  lldb_eval::EvalStats stats;
+
+  for (auto _ : state) {
+    if (batch) {
+      lldb_eval::EvaluateExpressions(frame, expressions.data(),
+                                     expressions.size(), values.data(),
+                                     errors.data(), &stats);
+    } else {
+      for (size_t i = 0; i < expressions.size(); ++i) {
+        values[i] = lldb_eval::EvaluateExpression(frame, expressions[i],
+                                                  errors[i], &stats);
+      }
+    }
+    benchmark::DoNotOptimize(values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * expressions.size());
+  state.counters["find_variable_calls"] = benchmark::Counter(
+      static_cast<double>(stats.find_variable_calls),
+      benchmark::Counter::kAvgIterations);
+}
+
+// Records the latency of every iteration and reports the percentiles as
+// counters, in addition to the mean time reported by the library.
+class LatencyRecorder {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit LatencyRecorder(benchmark::State& state) : state_(state) {
+    samples_.reserve(static_cast<size_t>(state.max_iterations));
+  }
+
+  ~LatencyRecorder() {
+    if (samples_.empty()) {
+      return;
+    }
+    state_.counters["p50_ns"] = Percentile(0.50);
+    state_.counters["p90_ns"] = Percentile(0.90);
+    state_.counters["p99_ns"] = Percentile(0.99);
+  }
+
+  void Record(Clock::time_point start) {
+    samples_.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count());
+  }
+
+ private:
+  double Percentile(double p) {
+    size_t n = static_cast<size_t>(p * (samples_.size() - 1));
+    std::nth_element(samples_.begin(), samples_.begin() + n, samples_.end());
+    return samples_[n];
+  }
+
+  benchmark::State& state_;
+  std::vector<double> samples_;
+};
+
+// Create a new context and parse the expression on every iteration.
+void BM_Parse(benchmark::State& state, const char* expr) {
+  lldb::SBExecutionContext exec_ctx(frame);
+  LatencyRecorder latency(state);
+
+  for (auto _ : state) {
+    auto start = LatencyRecorder::Clock::now();
+    lldb_eval::ExpressionContext expr_ctx(expr, exec_ctx);
+    lldb_eval::Parser p(expr_ctx);
+    lldb_eval::ExprResult tree = p.Run();
+    benchmark::DoNotOptimize(tree);
+    latency.Record(start);
+
+    if (p.HasError()) {
+      state.SkipWithError(p.GetError().c_str());
+      break;
+    }
+  }
+}
+
+// Parse the expression once and evaluate the tree on every iteration,
+// including the conversion of the result to SBValue.
+void BM_Evaluate(benchmark::State& state, const char* expr) {
+  lldb::SBExecutionContext exec_ctx(frame);
+  lldb_eval::ExpressionContext expr_ctx(expr, exec_ctx);
+  lldb_eval::Parser p(expr_ctx);
+  lldb_eval::ExprResult tree = p.Run();
+  if (p.HasError()) {
+    state.SkipWithError(p.GetError().c_str());
+    return;
+  }
+
+  LatencyRecorder latency(state);
+
+  for (auto _ : state) {
+    auto start = LatencyRecorder::Clock::now();
+    lldb_eval::Interpreter eval(expr_ctx);
+    lldb_eval::EvalError error;
+    lldb_eval::Value result = eval.Eval(tree, error);
+    lldb::SBValue value = result.AsSbValue(exec_ctx.GetTarget());
+    benchmark::DoNotOptimize(value);
+    latency.Record(start);
+
+    if (error) {
+      state.SkipWithError(error.message().c_str());
+      break;
+    }
+  }
+}
+
+// Go through the public API, i.e. parse and evaluate on every iteration.
+void BM_EndToEnd(benchmark::State& state, const char* expr) {
+  LatencyRecorder latency(state);
+
+  for (auto _ : state) {
+    auto start = LatencyRecorder::Clock::now();
+    lldb::SBError error;
+    lldb::SBValue value = lldb_eval::EvaluateExpression(frame, expr, error);
+    benchmark::DoNotOptimize(value);
+    latency.Record(start);
+
+    if (error.Fail()) {
+      state.SkipWithError(error.GetCString());
+      break;
+    }
+  }
+}
+
+// Evaluate the tree with the tree walker on every iteration. Unlike
+// `BM_Evaluate`, the result isn't converted to SBValue, so only the evaluation
+// itself is measured.
+void BM_TreeWalker(benchmark::State& state, const char* expr) {
+  lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext(frame));
+  lldb_eval::Parser p(expr_ctx);
+  lldb_eval::ExprResult tree = p.Run();
+  if (p.HasError()) {
+    state.SkipWithError(p.GetError().c_str());
+    return;
+  }
+
+  lldb_eval::Interpreter interpreter(expr_ctx);
+  for (auto _ : state) {
+    lldb_eval::EvalError error;
+    lldb_eval::Value result = interpreter.Eval(tree, error);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Heap allocations of the tree walker per evaluation. The size of the values
+// it passes around is reported as well, since every node produces one.
+void BM_TreeWalkerAllocations(benchmark::State& state, const char* expr) {
+  lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext(frame));
+  lldb_eval::Parser p(expr_ctx);
+  lldb_eval::ExprResult tree = p.Run();
+  if (p.HasError()) {
+    state.SkipWithError(p.GetError().c_str());
+    return;
+  }
+
+  lldb_eval::Interpreter interpreter(expr_ctx);
+  size_t num_allocations = 0;
+  for (auto _ : state) {
+    size_t before = g_num_allocations;
+    {
+      lldb_eval::EvalError error;
+      lldb_eval::Value result = interpreter.Eval(tree, error);
+      benchmark::DoNotOptimize(result);
+    }
+    num_allocations += g_num_allocations - before;
+  }
+
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(num_allocations), benchmark::Counter::kAvgIterations);
+  state.counters["sizeof_value"] =
+      static_cast<double>(sizeof(lldb_eval::Value));
+}
+
+// Compile the tree to bytecode once and run it on every iteration.
+void BM_Bytecode(benchmark::State& state, const char* expr) {
+  lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext(frame));
+  lldb_eval::Parser p(expr_ctx);
+  lldb_eval::ExprResult tree = p.Run();
+  if (p.HasError()) {
+    state.SkipWithError(p.GetError().c_str());
+    return;
+  }
+
+  lldb_eval::Bytecode bytecode = lldb_eval::Bytecode::Compile(tree);
+  lldb_eval::VirtualMachine vm(expr_ctx);
+  for (auto _ : state) {
+    lldb_eval::EvalError error;
+    lldb_eval::Value result = vm.Run(bytecode, error);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Scalar result of a compiled expression, e.g. for a numeric plot.
+const char* kScalarExpression = "a * 2 + ns_myint_";
+
+// Evaluate the expression and create an SBValue for the result.
+void BM_ScalarResultSbValue(benchmark::State& state) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 kScalarExpression, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  for (auto _ : state) {
+    lldb::SBValue value = expr.Evaluate(frame, error);
+    int64_t result = value.GetValueAsSigned();
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Evaluate the expression and get the result in the native form.
+void BM_ScalarResultNative(benchmark::State& state) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 kScalarExpression, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  for (auto _ : state) {
+    lldb_eval::EvalResult value = expr.EvaluateNative(frame, error);
+    int64_t result = value.GetInt64();
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Returns `lldb_eval::TypeInfoCache::kMaxTypes` distinct types: the basic
+// types and the pointers to them.
+std::vector<lldb::SBType> MakeDistinctTypes() {
+  const lldb::BasicType kBasicTypes[] = {
+      lldb::eBasicTypeBool,
+      lldb::eBasicTypeChar,
+      lldb::eBasicTypeSignedChar,
+      lldb::eBasicTypeUnsignedChar,
+      lldb::eBasicTypeWChar,
+      lldb::eBasicTypeChar16,
+      lldb::eBasicTypeChar32,
+      lldb::eBasicTypeShort,
+      lldb::eBasicTypeUnsignedShort,
+      lldb::eBasicTypeInt,
+      lldb::eBasicTypeUnsignedInt,
+      lldb::eBasicTypeLong,
+      lldb::eBasicTypeUnsignedLong,
+      lldb::eBasicTypeLongLong,
+      lldb::eBasicTypeUnsignedLongLong,
+      lldb::eBasicTypeFloat,
+      lldb::eBasicTypeDouble,
+      lldb::eBasicTypeLongDouble,
+  };
+  lldb::SBTarget target = frame.GetThread().GetProcess().GetTarget();
+  std::vector<lldb::SBType> types;
+  for (lldb::BasicType basic_type : kBasicTypes) {
+    lldb::SBType type = target.GetBasicType(basic_type);
+    for (int i = 0; i < 4; ++i) {
+      types.push_back(type);
+      type = type.GetPointerType();
+    }
+  }
+  types.resize(std::min(types.size(), lldb_eval::TypeInfoCache::kMaxTypes));
+  return types;
+}
+
+// The properties of a type computed through the SB API on every query, i.e.
+// without the type info cache.
+void BM_TypeInfoComputed(benchmark::State& state) {
+  lldb::SBType type = MakeDistinctTypes().back();
+  for (auto _ : state) {
+    lldb_eval::TypeInfo info = lldb_eval::GetTypeInfo(type);
+    benchmark::DoNotOptimize(info.flags);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The worst case of the type info cache: it's full and the type is the last
+// one of the linear search. This must stay well below `BM_TypeInfoComputed`
+// for the cache to pay off.
+void BM_TypeInfoCachedWorstCase(benchmark::State& state) {
+  std::vector<lldb::SBType> types = MakeDistinctTypes();
+  lldb_eval::TypeInfoCache cache;
+  lldb_eval::TypeInfoScope scope(&cache);
+  for (const lldb::SBType& type : types) {
+    lldb_eval::GetTypeInfo(type);
+  }
+
+  lldb::SBType type = types.back();
+  for (auto _ : state) {
+    lldb_eval::TypeInfo info = lldb_eval::GetTypeInfo(type);
+    benchmark::DoNotOptimize(info.flags);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Condition of the breakpoint in the hot loop of the test program.
+const char* kCondition = "i % 100 == 99";
+
+// Evaluate the condition and check the resulting SBValue, which is what a
+// debugger has to do without `EvaluateCondition()`.
+void BM_ConditionSbValue(benchmark::State& state) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 kCondition, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  for (auto _ : state) {
+    lldb::SBValue value = expr.Evaluate(frame, error);
+    bool result = value.GetValueAsUnsigned() != 0;
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Evaluate the condition directly to bool.
+void BM_ConditionNative(benchmark::State& state) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 kCondition, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  for (auto _ : state) {
+    bool result;
+    lldb_eval::EvaluateCondition(frame, expr, &result, error);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Evaluate a condition which fails with a type error, e.g. a condition
+// comparing a struct. `code_only` selects the overload which doesn't format
+// the error message. The heap allocations per evaluation are reported.
+void BM_ConditionError(benchmark::State& state, bool code_only) {
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(frame.GetThread().GetProcess().GetTarget(),
+                                 "c == i", error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  size_t num_allocations = 0;
+  for (auto _ : state) {
+    size_t before = g_num_allocations;
+    bool result;
+    if (code_only) {
+      uint32_t error_code;
+      lldb_eval::EvaluateCondition(frame, expr, &result, &error_code);
+    } else {
+      lldb_eval::EvaluateCondition(frame, expr, &result, error);
+    }
+    benchmark::DoNotOptimize(result);
+    num_allocations += g_num_allocations - before;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(num_allocations), benchmark::Counter::kAvgIterations);
+}
+
+// Resume the process on every iteration and evaluate the condition when it
+// hits the breakpoint in the hot loop, i.e. the items per second are the
+// condition hits per second. `use_sb_value` selects the way of evaluation.
+void BM_ConditionHits(benchmark::State& state, bool use_sb_value) {
+  lldb::SBProcess process = frame.GetThread().GetProcess();
+  lldb::SBTarget target = process.GetTarget();
+  lldb::SBError error;
+  auto expr = lldb_eval::Compile(target, kCondition, error);
+  if (!expr.IsValid()) {
+    state.SkipWithError(error.GetCString());
+    return;
+  }
+
+  lldb::SBBreakpoint bp = target.BreakpointCreateByLocation(
+      "test_binary.cc", frame.GetLineEntry().GetLine());
+  int64_t stops = 0;
+
+  for (auto _ : state) {
+    process.Continue();
+    lldb_eval::WaitForBreakpoint(target.GetDebugger(), process, bp);
+    lldb::SBFrame hit_frame = process.GetSelectedThread().GetSelectedFrame();
+
+    bool result;
+    if (use_sb_value) {
+      lldb::SBValue value = expr.Evaluate(hit_frame, error);
+      result = value.GetValueAsUnsigned() != 0;
+    } else {
+      lldb_eval::EvaluateCondition(hit_frame, expr, &result, error);
+    }
+    if (error.Fail()) {
+      state.SkipWithError(error.GetCString());
+      break;
+    }
+    stops += result ? 1 : 0;
+  }
+
+  target.BreakpointDelete(bp.GetID());
+  // The loop has moved on, the other benchmarks need the current frame.
+  frame = process.GetSelectedThread().GetSelectedFrame();
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["stops"] = static_cast<double>(stops);
+}
+
+// Location in the test program together with the expressions measured there.
+// The sites are listed in the order they are reached by the test program.
+struct BreakSite {
+  const char* name;
+  std::vector<const char*> expressions;
+};
+
+const BreakSite kBreakSites[] = {
+    {"TestArithmetic",
+     {"1 + 2*3", "a + 1", "uint_max + 1", "ull_max + 1", "-20LL / 1U"}},
+    {"TestPointerArithmetic",
+     {"*(p_char1 + 2)", "cp_int5 - p_int0", "*(&*(cp_int5 + 1) - 1)",
+      "cp_int5 == td_int_ptr0 + offset"}},
+    {"TestLogicalOperators",
+     {"trueVar && (2 < 1)", "falseVar || (2 < 1)", "p_ptr && false"}},
+    {"TestLocalVariables", {"a", "a + b", "s + 1"}},
+    {"TestInstanceVariables", {"this->field_", "c.field_", "c_ptr->field_"}},
+    {"TestIndirection",
+     {"*p", "*&val", "n0.value", "head->next->next->next->value",
+      "n0.next->next->next->value"}},
+    {"TestAddressOf", {"&globalVar", "&s_str"}},
+    {"TestSubscript",
+     {"1[char_ptr]", "c_arr[0].field_", "td_int_arr[td_td_int_idx_2]",
+      "(&c_arr[1])->field_"}},
+    {"TestCStyleCastBasicType",
+     {"(int)f", "(ns::myint)1", "(ns::inner::mydouble)myint_",
+      "*(const int* const)ap", kExpression}},
+    {"TestQualifiedId", {"::ns::i", "::ns::ns::i", "::Foo::y"}},
+    {"TestTemplateTypes",
+     {"(T_1<int>::myint)1.1", "(ns::T_1<ns::T_1<int> >::myint)1.1"}},
+    {"TestBreakpointCondition", {"i % 100 == 99", "c.field_ == i"}},
+};
+
+// Arithmetic and logical expressions of eval_test.cc, which are evaluated by
+// both the tree walker and the bytecode VM.
+const BreakSite kBytecodeSites[] = {
+    {"TestArithmetic",
+     {"1 + 2*3", "1 + (2 - 3)", "int_max + 1", "uint_zero - 1",
+      "ll_min - 1", "ull_max + 1", "-20LL / 1ULL", "a + 1 == 2"}},
+    {"TestLogicalOperators",
+     {"1 > 0.1", "0 || 1", "trueVar && (2 > 1)", "falseVar || (2 < 1)",
+      "p_ptr && false", "p_nullptr || true"}},
+};
+
+// Registers the latency benchmarks for the expressions of the given site,
+// e.g. "TestLocalVariables/Parse/a + b".
+void RegisterLatencyBenchmarks(const BreakSite& site) {
+  for (const char* expr : site.expressions) {
+    std::string prefix = std::string(site.name) + "/";
+    benchmark::RegisterBenchmark((prefix + "Parse/" + expr).c_str(), BM_Parse,
+                                 expr);
+    benchmark::RegisterBenchmark((prefix + "Evaluate/" + expr).c_str(),
+                                 BM_Evaluate, expr);
+    benchmark::RegisterBenchmark((prefix + "EndToEnd/" + expr).c_str(),
+                                 BM_EndToEnd, expr);
+  }
+}
+
+// Registers the benchmarks of the evaluators for the given site, e.g.
+// "TestArithmetic/Bytecode/1 + 2*3". Does nothing if the site has no such
+// benchmarks.
+void RegisterBytecodeBenchmarks(const BreakSite& site) {
+  for (const BreakSite& bytecode_site : kBytecodeSites) {
+    if (std::strcmp(site.name, bytecode_site.name) != 0) {
+      continue;
+    }
+    for (const char* expr : bytecode_site.expressions) {
+      std::string prefix = std::string(site.name) + "/";
+      benchmark::RegisterBenchmark((prefix + "TreeWalker/" + expr).c_str(),
+                                   BM_TreeWalker, expr);
+      benchmark::RegisterBenchmark((prefix + "Bytecode/" + expr).c_str(),
+                                   BM_Bytecode, expr);
+      benchmark::RegisterBenchmark(
+          (prefix + "TreeWalkerAllocations/" + expr).c_str(),
+          BM_TreeWalkerAllocations, expr);
+    }
+  }
+}
+
+// Deep expressions, which measure the per-node overhead of the evaluators.
+// They are run at the site of `TestArithmetic`, where `a` is 1.
+const char* kDeepExpressionSite = "TestArithmetic";
+
+// "a + a + ... + a" with `n` terms.
+std::string MakePlusChain(int n) {
+  std::string expr = "a";
+  for (int i = 1; i < n; ++i) {
+    expr += " + a";
+  }
+  return expr;
+}
+
+// "a > 0 ? a > 0 ? ... 1 : 0 : 0" with `n` nested ternary operators.
+std::string MakeNestedTernary(int n) {
+  std::string expr;
+  for (int i = 0; i < n; ++i) {
+    expr += "a > 0 ? ";
+  }
+  expr += "1";
+  for (int i = 0; i < n; ++i) {
+    expr += " : 0";
+  }
+  return expr;
+}
+
+void RegisterDeepExpressionBenchmarks() {
+  // The benchmarks refer to the expressions until they are run.
+  static const std::vector<std::pair<std::string, std::string>> exprs = {
+      {"PlusChain/10", MakePlusChain(10)},
+      {"PlusChain/100", MakePlusChain(100)},
+      {"PlusChain/1000", MakePlusChain(1000)},
+      {"NestedTernary/10", MakeNestedTernary(10)},
+      {"NestedTernary/100", MakeNestedTernary(100)},
+  };
+  for (const auto& expr : exprs) {
+    benchmark::RegisterBenchmark(("Deep/TreeWalker/" + expr.first).c_str(),
+                                 BM_TreeWalker, expr.second.c_str());
+    benchmark::RegisterBenchmark(("Deep/Bytecode/" + expr.first).c_str(),
+                                 BM_Bytecode, expr.second.c_str());
+  }
+}
+
+// Benchmarks comparing different evaluation paths of the API, they are run
+// at the site of `kExpression`.
+const char* kComparisonSite = "TestCStyleCastBasicType";
+
+void RegisterComparisonBenchmarks() {
+  benchmark::RegisterBenchmark("BM_EvaluateExpression", BM_EvaluateExpression);
+  benchmark::RegisterBenchmark("BM_EvaluateCompiledExpression",
+                               BM_EvaluateCompiledExpression);
+  benchmark::RegisterBenchmark("BM_EvaluateExpressionsLoop",
+                               BM_EvaluateExpressionsLoop);
+  benchmark::RegisterBenchmark("BM_EvaluateExpressionsBatch",
+                               BM_EvaluateExpressionsBatch);
+  benchmark::RegisterBenchmark("BM_EvaluateIdentifiersLoop",
+                               BM_EvaluateIdentifiers, false);
+  benchmark::RegisterBenchmark("BM_EvaluateIdentifiersBatch",
+                               BM_EvaluateIdentifiers, true);
+  benchmark::RegisterBenchmark("BM_ScalarResultSbValue",
+                               BM_ScalarResultSbValue);
+  benchmark::RegisterBenchmark("BM_ScalarResultNative", BM_ScalarResultNative);
+  benchmark::RegisterBenchmark("BM_TypeInfoComputed", BM_TypeInfoComputed);
+  benchmark::RegisterBenchmark("BM_TypeInfoCachedWorstCase",
+                               BM_TypeInfoCachedWorstCase);
+}
+
+// Benchmarks of the breakpoint conditions, they are run at the site of the
+// hot loop.
+const char* kConditionSite = "TestBreakpointCondition";
+
+// The hits are measured only if the process is live, i.e. can be resumed.
+void RegisterConditionBenchmarks(bool live) {
+  benchmark::RegisterBenchmark("BM_ConditionSbValue", BM_ConditionSbValue);
+  benchmark::RegisterBenchmark("BM_ConditionNative", BM_ConditionNative);
+  benchmark::RegisterBenchmark("BM_ConditionErrorMessage", BM_ConditionError,
+                               false);
+  benchmark::RegisterBenchmark("BM_ConditionErrorCode", BM_ConditionError,
+                               true);
+  if (live) {
+    benchmark::RegisterBenchmark("BM_ConditionHitsSbValue", BM_ConditionHits,
+                                 true);
+    benchmark::RegisterBenchmark("BM_ConditionHitsNative", BM_ConditionHits,
+                                 false);
+  }
+}
+
+// Registers all benchmarks of the given site, `frame` must be stopped there.
+void RegisterSiteBenchmarks(const BreakSite& site, bool live) {
+  benchmark::ClearRegisteredBenchmarks();
+  RegisterLatencyBenchmarks(site);
+  RegisterBytecodeBenchmarks(site);
+  if (std::strcmp(site.name, kDeepExpressionSite) == 0) {
+    RegisterDeepExpressionBenchmarks();
+  }
+  if (std::strcmp(site.name, kComparisonSite) == 0) {
+    RegisterComparisonBenchmarks();
+  }
+  if (std::strcmp(site.name, kConditionSite) == 0) {
+    RegisterConditionBenchmarks(live);
+  }
+}
+
+// Returns the value of the "--core_dir=<dir>" flag, or an empty string if it's
+// not set. With the flag the benchmarks are run on core dumps of the test
+// program saved in <dir> (the missing ones are saved first), so the results
+// don't depend on a live process.
+std::string GetCoreDir(int argc, char** argv) {
+  const char kFlag[] = "--core_dir=";
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], kFlag, sizeof(kFlag) - 1) == 0) {
+      return argv[i] + sizeof(kFlag) - 1;
+    }
+  }
+  return "";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  std::unique_ptr<Runfiles> runfiles(Runfiles::Create(argv[0]));
+
+  lldb_eval::SetupLLDBServerEnv(*runfiles);
+  lldb::SBDebugger::Initialize();
+  lldb::SBDebugger debugger = lldb::SBDebugger::Create(false);
+
+  std::string core_dir = GetCoreDir(argc, argv);
+  if (!core_dir.empty()) {
+    std::vector<std::string> sites;
+    for (const BreakSite& site : kBreakSites) {
+      sites.push_back(site.name);
+    }
+    std::vector<std::string> cores;
+    std::string error;
+    if (!lldb_eval::SaveTestProgramCores(*runfiles, debugger, sites, core_dir,
+                                         &cores, &error)) {
+      std::cerr << "--core_dir can't be used: " << error << std::endl;
+      lldb::SBDebugger::Terminate();
+      return 1;
+    }
+
+    for (size_t i = 0; i < sites.size(); ++i) {
+      lldb::SBProcess process =
+          lldb_eval::LoadTestProgramCore(*runfiles, debugger, cores[i]);
+      frame = process.GetSelectedThread().GetSelectedFrame();
+
+      RegisterSiteBenchmarks(kBreakSites[i], /*live=*/false);
+      benchmark::RunSpecifiedBenchmarks();
+      lldb::SBTarget target = process.GetTarget();
+      debugger.DeleteTarget(target);
+    }
+
+    lldb::SBDebugger::Terminate();
+    return 0;
+  }
+
+  // Launch the test program once and stop at every site in turn. Only the
+  // benchmarks of the current site are registered, since the frames of the
+  // other sites are not available.
+  lldb::SBProcess process;
+  for (const BreakSite& site : kBreakSites) {
+    std::string break_line = "// BREAK(" + std::string(site.name) + ")";
+    if (!process.IsValid()) {
+      process = lldb_eval::LaunchTestProgram(*runfiles, debugger, break_line);
+    } else {
+      lldb_eval::ContinueToBreakpoint(*runfiles, process, break_line);
+    }
+    frame = process.GetSelectedThread().GetSelectedFrame();
+
+    RegisterSiteBenchmarks(site, /*live=*/true);
+    benchmark::RunSpecifiedBenchmarks();
+  }
+
+  process.Destroy();
+  lldb::SBDebugger::Terminate();
+
+  return 0;
+}
@@ -14,17 +14,30 @@
 
 #include "eval.h"
 
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "api.h"
 #include "ast.h"
+#include "bytecode.h"
+#include "constant_folding.h"
 #include "expression_context.h"
+#include "lldb/API/SBBreakpoint.h"
 #include "lldb/API/SBDebugger.h"
 #include "lldb/API/SBExecutionContext.h"
 #include "lldb/API/SBFrame.h"
+#include "lldb/API/SBLineEntry.h"
 #include "lldb/API/SBProcess.h"
 #include "lldb/API/SBTarget.h"
 #include "lldb/API/SBThread.h"
+#include "memory_cache.h"
 #include "parser.h"
 #include "runner.h"
 #include "tools/cpp/runfiles/runfiles.h"
@@ -40,15 +53,89 @@ namespace {
 
 using bazel::tools::cpp::runfiles::Runfiles;
 
+using Clock = std::chrono::steady_clock;
+
+// Tests which resume the process or expect the caches of the target to be
+// empty. They get a debuggee of their own, the others share one.
+const char* kIsolatedTests[] = {
+    "TestWatchList",
+    "TestTypeCache",
+    "TestGlobalVariableCache",
+    "TestMemberCache",
+    "TestEvalStats",
+};
+
+bool IsIsolatedTest(const std::string& test_name) {
+  if (const char* isolated = std::getenv("LLDB_EVAL_TEST_ISOLATED")) {
+    if (std::strcmp(isolated, "0") != 0) {
+      return true;
+    }
+  }
+  for (const char* name : kIsolatedTests) {
+    if (test_name == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
 class InterpreterTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
     runfiles_ = Runfiles::CreateForTest();
     lldb_eval::SetupLLDBServerEnv(*runfiles_);
     lldb::SBDebugger::Initialize();
+    shared_debugger_ = lldb::SBDebugger::Create(false);
+
+    // With LLDB_EVAL_TEST_CORE_DIR=<dir> the shared tests run on core dumps
+    // saved in <dir> instead of a live process. The missing cores are saved
+    // up front.
+    if (const char* core_dir = std::getenv("LLDB_EVAL_TEST_CORE_DIR")) {
+      const ::testing::TestSuite* suite =
+          ::testing::UnitTest::GetInstance()->current_test_suite();
+      std::vector<std::string> sites;
+      for (int i = 0; i < suite->total_test_count(); ++i) {
+        const ::testing::TestInfo* test = suite->GetTestInfo(i);
+        if (test->should_run() && !IsIsolatedTest(test->name())) {
+          sites.push_back(test->name());
+        }
+      }
+
+      Clock::time_point start = Clock::now();
+      std::vector<std::string> cores;
+      std::string error;
+      if (lldb_eval::SaveTestProgramCores(*runfiles_, shared_debugger_, sites,
+                                          core_dir, &cores, &error)) {
+        for (size_t i = 0; i < sites.size(); ++i) {
+          core_paths_[sites[i]] = cores[i];
+        }
+      } else {
+        // The shared tests are skipped rather than run on a live process, the
+        // core dumps were asked for explicitly.
+        cores_error_ = error;
+        std::cout << "[ DEBUGGEE ] " << error << std::endl;
+      }
+      setup_time_ += Clock::now() - start;
+    }
   }
 
   static void TearDownTestSuite() {
+    shared_process_.Destroy();
+    shared_process_ = lldb::SBProcess();
+    shared_debugger_ = lldb::SBDebugger();
+
+    // Compare with LLDB_EVAL_TEST_ISOLATED=1 to see what sharing the
+    // debuggee saves.
+    int64_t setup_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           setup_time_)
+                           .count();
+    std::cout << "[ DEBUGGEE ] " << num_launches_ << " launches, "
+              << num_continues_ << " continues, " << num_cores_
+              << " cores, " << setup_ms << " ms to reach the breakpoints"
+              << std::endl;
+    RecordProperty("debuggee_launches", num_launches_);
+    RecordProperty("debuggee_setup_ms", static_cast<int>(setup_ms));
+
     lldb::SBDebugger::Terminate();
     delete runfiles_;
     runfiles_ = nullptr;
@@ -58,17 +145,54 @@ class InterpreterTest : public ::testing::Test {
     std::string test_name =
         ::testing::UnitTest::GetInstance()->current_test_info()->name();
     std::string break_line = "// BREAK(" + test_name + ")";
-
-    debugger_ = lldb::SBDebugger::Create(false);
-    process_ = lldb_eval::LaunchTestProgram(*runfiles_, debugger_, break_line);
+    Clock::time_point start = Clock::now();
+
+    // The shared debuggee goes through the breakpoints in the order of the
+    // program. It's launched again if the test needs an earlier one.
+    owns_process_ = true;
+    if (!cores_error_.empty() && !IsIsolatedTest(test_name)) {
+      owns_process_ = false;
+      GTEST_SKIP() << cores_error_;
+    }
+    auto core = core_paths_.find(test_name);
+    if (IsIsolatedTest(test_name)) {
+      debugger_ = lldb::SBDebugger::Create(false);
+      process_ =
+          lldb_eval::LaunchTestProgram(*runfiles_, debugger_, break_line);
+      ++num_launches_;
+    } else if (core != core_paths_.end()) {
+      debugger_ = shared_debugger_;
+      process_ = lldb_eval::LoadTestProgramCore(*runfiles_, debugger_,
+                                                core->second);
+      ++num_cores_;
+    } else {
+      owns_process_ = false;
+      if (shared_process_.IsValid() &&
+          lldb_eval::ContinueToBreakpoint(*runfiles_, shared_process_,
+                                          break_line)) {
+        ++num_continues_;
+      } else {
+        shared_process_.Destroy();
+        shared_process_ = lldb_eval::LaunchTestProgram(
+            *runfiles_, shared_debugger_, break_line);
+        ++num_launches_;
+      }
+      debugger_ = shared_debugger_;
+      process_ = shared_process_;
+    }
     frame_ = process_.GetSelectedThread().GetSelectedFrame();
+    setup_time_ += Clock::now() - start;
 
     // Evaluate expressions with both lldb-eval and LLDB by default.
     skip_lldb = false;
     expect_error_lldb = false;
   }
 
-  void TearDown() { process_.Destroy(); }
+  void TearDown() {
+    if (owns_process_) {
+      process_.Destroy();
+    }
+  }
 
   void EvaluateLldbEval(const std::string& expr, lldb::SBValue& result);
   void EvaluateLldb(const std::string& expr, lldb::SBValue& result);
@@ -91,6 +215,23 @@ class InterpreterTest : public ::testing::Test {
 
   bool skip_lldb;
   bool expect_error_lldb;
+  // Isolated tests and the tests running on a core have a process of their
+  // own, the others use the shared one.
+  bool owns_process_;
+
+  // The debuggee shared by the tests which are not isolated.
+  static lldb::SBDebugger shared_debugger_;
+  static lldb::SBProcess shared_process_;
+  // Core dumps of the shared tests by test name, if they are used.
+  static std::map<std::string, std::string> core_paths_;
+  // Why the core dumps can't be used, if they were asked for.
+  static std::string cores_error_;
+
+  // Time spent launching the debuggee and waiting for the breakpoints.
+  static Clock::duration setup_time_;
+  static int num_launches_;
+  static int num_continues_;
+  static int num_cores_;
 };
 
 class SkipLLDB {
@@ -116,6 +257,14 @@ class ExpectErrorLLDB {
 };
 
 Runfiles* InterpreterTest::runfiles_ = nullptr;
+lldb::SBDebugger InterpreterTest::shared_debugger_;
+lldb::SBProcess InterpreterTest::shared_process_;
+Clock::duration InterpreterTest::setup_time_ = Clock::duration::zero();
+int InterpreterTest::num_launches_ = 0;
+int InterpreterTest::num_continues_ = 0;
+int InterpreterTest::num_cores_ = 0;
+std::map<std::string, std::string> InterpreterTest::core_paths_;
+std::string InterpreterTest::cores_error_;
 
 void InterpreterTest::EvaluateLldbEval(const std::string& expr,
                                        lldb::SBValue& result) {
@@ -125,7 +274,7 @@ void InterpreterTest::EvaluateLldbEval(const std::string& expr,
   ASSERT_FALSE(p.HasError()) << p.GetError();
   lldb_eval::EvalError error;
   lldb_eval::Interpreter interpreter(expr_ctx);
-  auto ret = interpreter.Eval(expr_result.get(), error);
+  auto ret = interpreter.Eval(expr_result, error);
   EXPECT_EQ(error.code(), lldb_eval::EvalErrorCode::OK);
   EXPECT_EQ(error.message(), "");
   result = ret.AsSbValue(expr_ctx.GetExecutionContext().GetTarget());
@@ -177,7 +326,7 @@ void InterpreterTest::TestExprErr(const std::string& expr,
   ASSERT_FALSE(p.HasError()) << p.GetError();
   lldb_eval::EvalError error;
   lldb_eval::Interpreter interpreter(expr_ctx);
-  auto ret = interpreter.Eval(expr_result.get(), error);
+  auto ret = interpreter.Eval(expr_result, error);
   EXPECT_THAT(error.message(), ::testing::HasSubstr(msg));
 }
 
@@ -214,6 +363,27 @@ TEST_F(InterpreterTest, TestArithmetic) {
   TestExpr("-20 / 1U", "4294967276");
   TestExpr("-20LL / 1U", "-20");
   TestExpr("-20LL / 1ULL", "18446744073709551596");
+
+  // Integer division by zero and the division of the minimal value by -1 are
+  // undefined.
+  TestExprErr("1 / 0", "division by zero is undefined");
+  TestExprErr("a % 0", "remainder by zero is undefined");
+  TestExprErr("1 / uint_zero", "division by zero is undefined");
+  TestExprErr("int_min / -1", "overflow in expression");
+  TestExprErr("int_min % -1", "overflow in expression");
+  TestExprErr("ll_min / -1", "overflow in expression");
+  TestExprErr("ll_min / (a - 2)", "overflow in expression");
+  TestExpr("int_min / -1LL", "2147483648");
+  TestExpr("1U / -1", "0");
+
+  // Bitwise operators aren't defined for floating point operands, the result
+  // is an invalid value.
+  for (const char* expr : {"1.5 & 1", "1 | 2.5f", "1.5 ^ 2.5", "1.5 << 1"}) {
+    SCOPED_TRACE(expr);
+    lldb::SBValue result;
+    EvaluateLldbEval(expr, result);
+    EXPECT_FALSE(result.IsValid());
+  }
 }
 
 TEST_F(InterpreterTest, TestPointerArithmetic) {
@@ -581,4 +751,633 @@ TEST_F(InterpreterTest, TestTemplateTypes) {
   TestExpr("(::T_2<T_1<T_1<int> >, T_1<char> >::myint)1.1", "1.10000002");
 }
 
+TEST_F(InterpreterTest, TestCompiledExpression) {
+  lldb::SBTarget target = process_.GetTarget();
+  lldb::SBError error;
+
+  auto expr = lldb_eval::Compile(target, "a + b", error);
+  ASSERT_TRUE(expr.IsValid());
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+
+  // The same compiled expression can be evaluated multiple times.
+  for (int i = 0; i < 3; ++i) {
+    lldb::SBValue result = expr.Evaluate(frame_, error);
+    ASSERT_FALSE(error.Fail()) << error.GetCString();
+    EXPECT_STREQ(result.GetValue(), "3");
+  }
+
+  // Evaluate the same expression in the caller frame, where "a" and "b" don't
+  // exist.
+  lldb::SBFrame caller = frame_.GetThread().GetFrameAtIndex(1);
+  lldb::SBValue result = expr.Evaluate(caller, error);
+  EXPECT_TRUE(error.Fail());
+  EXPECT_THAT(error.GetCString(),
+              ::testing::HasSubstr("use of undeclared identifier 'a'"));
+  EXPECT_FALSE(result.IsValid());
+
+  // Syntax errors are reported when compiling the expression.
+  auto invalid_expr = lldb_eval::Compile(target, "a +", error);
+  EXPECT_FALSE(invalid_expr.IsValid());
+  EXPECT_EQ(error.GetError(),
+            static_cast<uint32_t>(
+                lldb_eval::EvalErrorCode::INVALID_EXPRESSION_SYNTAX));
+  EXPECT_THAT(error.GetCString(), ::testing::HasSubstr("Unexpected token"));
+}
+
+TEST_F(InterpreterTest, TestEvaluateCondition) {
+  lldb::SBTarget target = process_.GetTarget();
+  lldb::SBError error;
+
+  auto check = [&](const char* condition, bool expected) {
+    SCOPED_TRACE(condition);
+    auto expr = lldb_eval::Compile(target, condition, error);
+    ASSERT_TRUE(expr.IsValid()) << error.GetCString();
+
+    bool result = !expected;
+    lldb_eval::EvaluateCondition(frame_, expr, &result, error);
+    ASSERT_FALSE(error.Fail()) << error.GetCString();
+    EXPECT_EQ(result, expected);
+  };
+
+  // The breakpoint is hit in the first iteration.
+  check("i == 0", true);
+  check("i", false);
+  check("i + 1", true);
+  check("i % 100 == 99", false);
+  check("&sum", true);
+  check("(void*)0", false);
+  check("0.5", true);
+  check("c.field_ == 1337 && sum == 0", true);
+
+  auto expr = lldb_eval::Compile(target, "c", error);
+  ASSERT_TRUE(expr.IsValid()) << error.GetCString();
+  bool result = true;
+  lldb_eval::EvaluateCondition(frame_, expr, &result, error);
+  EXPECT_TRUE(error.Fail());
+  EXPECT_STREQ(error.GetCString(),
+               "value of type 'C' is not contextually convertible to 'bool'");
+  EXPECT_FALSE(result);
+
+  expr = lldb_eval::Compile(target, "__doesnt_exist", error);
+  ASSERT_TRUE(expr.IsValid()) << error.GetCString();
+  lldb_eval::EvaluateCondition(frame_, expr, &result, error);
+  EXPECT_THAT(error.GetCString(),
+              ::testing::HasSubstr("use of undeclared identifier"));
+
+  lldb_eval::EvaluateCondition(frame_, lldb_eval::CompiledExpression(),
+                               &result, error);
+  EXPECT_STREQ(error.GetCString(), "The expression is not compiled.");
+
+  // Only the error code is reported.
+  uint32_t error_code = 0;
+  lldb_eval::EvaluateCondition(frame_, expr, &result, &error_code);
+  EXPECT_EQ(error_code, static_cast<uint32_t>(
+                            lldb_eval::EvalErrorCode::UNDECLARED_IDENTIFIER));
+  EXPECT_FALSE(result);
+
+  expr = lldb_eval::Compile(target, "i == 0", error);
+  ASSERT_TRUE(expr.IsValid()) << error.GetCString();
+  lldb_eval::EvaluateCondition(frame_, expr, &result, &error_code);
+  EXPECT_EQ(error_code, 0u);
+  EXPECT_TRUE(result);
+}
+
+TEST_F(InterpreterTest, TestWatchList) {
+  lldb::SBTarget target = process_.GetTarget();
+
+  lldb_eval::WatchList watches(target);
+  watches.Add("i");
+  watches.Add("sum");
+  watches.Add("c.field_ + 1");
+  watches.Add("*&c.field_");
+  watches.Add("__doesnt_exist");
+  watches.Add("i +");
+  ASSERT_EQ(watches.size(), 6u);
+
+  lldb::SBValue results[6];
+  lldb::SBError errors[6];
+
+  // Everything is evaluated the first time.
+  lldb_eval::EvalStats stats;
+  watches.Evaluate(frame_, results, errors, &stats);
+  EXPECT_EQ(stats.results_reused, 0u);
+  EXPECT_STREQ(results[0].GetValue(), "0");
+  EXPECT_STREQ(results[1].GetValue(), "0");
+  EXPECT_STREQ(results[2].GetValue(), "1338");
+  EXPECT_STREQ(results[3].GetValue(), "1337");
+  EXPECT_THAT(errors[4].GetCString(),
+              ::testing::HasSubstr("use of undeclared identifier"));
+  EXPECT_THAT(errors[5].GetCString(),
+              ::testing::HasSubstr("Unexpected token"));
+
+  // Nothing has changed in the same stop. The syntax errors are not counted.
+  stats = lldb_eval::EvalStats();
+  watches.Evaluate(frame_, results, errors, &stats);
+  EXPECT_EQ(stats.results_reused, 5u);
+  EXPECT_STREQ(results[0].GetValue(), "0");
+  EXPECT_STREQ(results[2].GetValue(), "1338");
+
+  // Go to the next iteration of the loop, only "i" has changed ("sum" is still
+  // 0 after adding 0).
+  lldb::SBBreakpoint bp = target.BreakpointCreateByLocation(
+      "test_binary.cc", frame_.GetLineEntry().GetLine());
+  process_.Continue();
+  lldb_eval::WaitForBreakpoint(debugger_, process_, bp);
+  lldb::SBFrame frame = process_.GetSelectedThread().GetSelectedFrame();
+
+  stats = lldb_eval::EvalStats();
+  watches.Evaluate(frame, results, errors, &stats);
+  EXPECT_EQ(stats.results_reused, 4u);
+  EXPECT_STREQ(results[0].GetValue(), "1");
+  EXPECT_STREQ(results[1].GetValue(), "0");
+  EXPECT_STREQ(results[2].GetValue(), "1338");
+
+  // Now "sum" has changed too.
+  process_.Continue();
+  lldb_eval::WaitForBreakpoint(debugger_, process_, bp);
+  frame = process_.GetSelectedThread().GetSelectedFrame();
+
+  stats = lldb_eval::EvalStats();
+  watches.Evaluate(frame, results, errors, &stats);
+  EXPECT_EQ(stats.results_reused, 3u);
+  EXPECT_STREQ(results[0].GetValue(), "2");
+  EXPECT_STREQ(results[1].GetValue(), "1");
+
+  // The identifiers resolve to different variables in another frame.
+  stats = lldb_eval::EvalStats();
+  watches.Evaluate(frame.GetThread().GetFrameAtIndex(1), results, errors,
+                   &stats);
+  EXPECT_EQ(stats.results_reused, 1u);
+  EXPECT_TRUE(errors[0].Fail());
+}
+
+TEST_F(InterpreterTest, TestEvaluateInFrames) {
+  lldb::SBTarget target = process_.GetTarget();
+  lldb::SBError error;
+
+  auto expr = lldb_eval::Compile(target, "a + b", error);
+  ASSERT_TRUE(expr.IsValid()) << error.GetCString();
+
+  // Only the top frame has "a" and "b".
+  lldb::SBThread thread = frame_.GetThread();
+  const size_t count = thread.GetNumFrames();
+  ASSERT_GE(count, 2u);
+
+  std::vector<lldb::SBFrame> frames;
+  for (size_t i = 0; i < count; ++i) {
+    frames.push_back(thread.GetFrameAtIndex(i));
+  }
+  std::vector<lldb::SBValue> results(count);
+  std::vector<lldb::SBError> errors(count);
+
+  for (size_t num_threads : {0, 1, 4}) {
+    SCOPED_TRACE(num_threads);
+    lldb_eval::EvaluateInFrames(expr, frames.data(), count, results.data(),
+                                errors.data(), num_threads);
+
+    ASSERT_FALSE(errors[0].Fail()) << errors[0].GetCString();
+    EXPECT_STREQ(results[0].GetValue(), "3");
+    for (size_t i = 1; i < count; ++i) {
+      EXPECT_TRUE(errors[i].Fail());
+      EXPECT_THAT(errors[i].GetCString(),
+                  ::testing::HasSubstr("use of undeclared identifier 'a'"));
+    }
+  }
+
+  // The workers share the compiled expression and the target cache, the
+  // results must not depend on the number of threads. The global variable and
+  // the type are resolved in every frame.
+  const char* shared_lookups[] = {"a + b", "::globalVar + (ns::myint)1"};
+  for (const char* text : shared_lookups) {
+    SCOPED_TRACE(text);
+    auto shared_expr = lldb_eval::Compile(target, text, error);
+    ASSERT_TRUE(shared_expr.IsValid()) << error.GetCString();
+
+    std::vector<lldb::SBValue> expected_results(count);
+    std::vector<lldb::SBError> expected_errors(count);
+    lldb_eval::EvaluateInFrames(shared_expr, frames.data(), count,
+                                expected_results.data(),
+                                expected_errors.data(), /*num_threads=*/1);
+    lldb_eval::EvaluateInFrames(shared_expr, frames.data(), count,
+                                results.data(), errors.data(),
+                                /*num_threads=*/4);
+
+    for (size_t i = 0; i < count; ++i) {
+      SCOPED_TRACE(i);
+      EXPECT_EQ(errors[i].Fail(), expected_errors[i].Fail());
+      EXPECT_STREQ(errors[i].GetCString(), expected_errors[i].GetCString());
+      EXPECT_STREQ(results[i].GetValue(), expected_results[i].GetValue());
+      EXPECT_STREQ(results[i].GetTypeName(),
+                   expected_results[i].GetTypeName());
+    }
+  }
+
+  // The test program has a single thread.
+  size_t num_threads = process_.GetNumThreads();
+  results.assign(num_threads, lldb::SBValue());
+  errors.assign(num_threads, lldb::SBError());
+  EXPECT_EQ(lldb_eval::EvaluateInAllThreads(process_, expr, results.data(),
+                                            errors.data(), num_threads),
+            num_threads);
+  ASSERT_FALSE(errors[0].Fail()) << errors[0].GetCString();
+  EXPECT_STREQ(results[0].GetValue(), "3");
+}
+
+TEST_F(InterpreterTest, TestTypeCache) {
+  lldb::SBTarget target = process_.GetTarget();
+
+  lldb_eval::TargetCacheStats stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.types.hits, 0u);
+  EXPECT_EQ(stats.types.misses, 0u);
+
+  // The type is looked up by the parser and then again by the interpreter.
+  TestExpr("(ns::myint)1", "1");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.types.hits, 1u);
+  EXPECT_EQ(stats.types.misses, 1u);
+
+  TestExpr("(ns::myint)2", "2");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.types.hits, 3u);
+  EXPECT_EQ(stats.types.misses, 1u);
+
+  // Types which don't exist are cached as well.
+  TestExpr("(a) + 1", "2");
+  TestExpr("(a) + 2", "3");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.types.hits, 4u);
+  EXPECT_EQ(stats.types.misses, 2u);
+  EXPECT_EQ(stats.invalidations, 0u);
+}
+
+TEST_F(InterpreterTest, TestGlobalVariableCache) {
+  lldb::SBTarget target = process_.GetTarget();
+
+  TestExpr("::globalVar", "-559038737");
+  lldb_eval::TargetCacheStats stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.globals.hits, 0u);
+  EXPECT_EQ(stats.globals.misses, 1u);
+
+  // The cached variable is still an lvalue and its value is read every time.
+  TestExpr("::globalVar", "-559038737");
+  TestExprOnlyCompare("&::globalVar");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.globals.hits, 2u);
+  EXPECT_EQ(stats.globals.misses, 1u);
+
+  // Unknown names are cached as well.
+  TestExprErr("::Foo::x", "use of undeclared identifier '::Foo::x'");
+  TestExprErr("::Foo::x", "use of undeclared identifier '::Foo::x'");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.globals.hits, 3u);
+  EXPECT_EQ(stats.globals.misses, 2u);
+
+  // Thread-local variables have a different address in every thread, they are
+  // looked up again every time.
+  {
+    // LLDB's own evaluator doesn't support the thread-local variables on all
+    // platforms.
+    SkipLLDB _(this);
+    TestExpr("::threadLocalVar", "42");
+    TestExpr("::threadLocalVar", "42");
+  }
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.globals.hits, 3u);
+  EXPECT_EQ(stats.globals.misses, 4u);
+}
+
+TEST_F(InterpreterTest, TestMemberCache) {
+  lldb::SBTarget target = process_.GetTarget();
+
+  TestExpr("c_arr[0].field_", "0");
+  lldb_eval::TargetCacheStats stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.members.hits, 0u);
+  EXPECT_EQ(stats.members.misses, 1u);
+
+  // The member is located at the cached offset of the object it belongs to.
+  TestExpr("c_arr[1].field_", "1");
+  TestExpr("(&c_arr[1])->field_", "1");
+  TestExprOnlyCompare("&c_arr[1].field_");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.members.hits, 3u);
+  EXPECT_EQ(stats.members.misses, 1u);
+
+  // Members which don't exist are cached as well.
+  TestExprErr("c_arr[0].x", "no member named 'x' in 'C'");
+  TestExprErr("c_arr[1].x", "no member named 'x' in 'C'");
+  stats = lldb_eval::GetTargetCacheStats(target);
+  EXPECT_EQ(stats.members.hits, 4u);
+  EXPECT_EQ(stats.members.misses, 2u);
+}
+
+TEST_F(InterpreterTest, TestEvaluateExpressions) {
+  const char* expressions[] = {"a + b", "a +", "c", "b * 2"};
+  const size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+  lldb::SBValue results[count];
+  lldb::SBError errors[count];
+  lldb_eval::EvaluateExpressions(frame_, expressions, count, results, errors);
+
+  ASSERT_FALSE(errors[0].Fail()) << errors[0].GetCString();
+  EXPECT_STREQ(results[0].GetValue(), "3");
+
+  // Errors don't stop the evaluation of the rest of the batch.
+  EXPECT_TRUE(errors[1].Fail());
+  EXPECT_EQ(errors[1].GetError(),
+            static_cast<uint32_t>(
+                lldb_eval::EvalErrorCode::INVALID_EXPRESSION_SYNTAX));
+  EXPECT_FALSE(results[1].IsValid());
+
+  EXPECT_TRUE(errors[2].Fail());
+  EXPECT_THAT(errors[2].GetCString(),
+              ::testing::HasSubstr("use of undeclared identifier 'c'"));
+  EXPECT_FALSE(results[2].IsValid());
+
+  ASSERT_FALSE(errors[3].Fail()) << errors[3].GetCString();
+  EXPECT_STREQ(results[3].GetValue(), "4");
+}
+
+TEST_F(InterpreterTest, TestFrameVariables) {
+  lldb::SBError error;
+  lldb_eval::EvalStats stats;
+
+  // Every identifier is looked up in the frame only once per evaluation.
+  lldb::SBValue result =
+      lldb_eval::EvaluateExpression(frame_, "a + a * a", error, &stats);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_STREQ(result.GetValue(), "2");
+  EXPECT_EQ(stats.find_variable_calls, 1u);
+
+  // The expressions of a batch share the lookups, including the misses.
+  const char* expressions[] = {"a", "b", "a + b", "a * b", "c", "c + 1"};
+  const size_t count = sizeof(expressions) / sizeof(expressions[0]);
+
+  lldb::SBValue results[count];
+  lldb::SBError errors[count];
+  stats = lldb_eval::EvalStats();
+  lldb_eval::EvaluateExpressions(frame_, expressions, count, results, errors,
+                                 &stats);
+
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_FALSE(errors[i].Fail()) << errors[i].GetCString();
+  }
+  EXPECT_STREQ(results[2].GetValue(), "3");
+  EXPECT_STREQ(results[3].GetValue(), "2");
+  EXPECT_TRUE(errors[4].Fail());
+  EXPECT_TRUE(errors[5].Fail());
+  // "a" and "b", then "c" and "this" for the miss.
+  EXPECT_EQ(stats.find_variable_calls, 4u);
+}
+
+TEST_F(InterpreterTest, TestEvalStats) {
+  lldb::SBError error;
+  lldb_eval::EvalStats stats;
+
+  lldb::SBValue result =
+      lldb_eval::EvaluateExpression(frame_, "a + b", error, &stats);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_STREQ(result.GetValue(), "3");
+
+  EXPECT_GT(stats.parse_time_ns, 0u);
+  EXPECT_GT(stats.eval_time_ns, 0u);
+  EXPECT_EQ(stats.find_types_calls, 0u);
+  EXPECT_EQ(stats.find_variable_calls, 2u);
+  EXPECT_EQ(stats.find_global_variables_calls, 0u);
+  EXPECT_EQ(stats.sb_values_created, 1u);
+  EXPECT_EQ(stats.bytes_read, 8u);
+
+  // The statistics are accumulated. The type and the global variable are
+  // looked up only once, the second time they come from the target cache.
+  for (int i = 0; i < 2; ++i) {
+    result = lldb_eval::EvaluateExpression(frame_, "(ns::myint)::globalVar",
+                                           error, &stats);
+    ASSERT_FALSE(error.Fail()) << error.GetCString();
+  }
+  EXPECT_EQ(stats.find_types_calls, 1u);
+  EXPECT_EQ(stats.find_variable_calls, 2u);
+  EXPECT_EQ(stats.find_global_variables_calls, 1u);
+
+  // Compiled expressions are not parsed when evaluated.
+  lldb_eval::EvalStats compiled_stats;
+  auto expr = lldb_eval::Compile(process_.GetTarget(), "a", error);
+  ASSERT_TRUE(expr.IsValid());
+  result = expr.Evaluate(frame_, error, &compiled_stats);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(compiled_stats.parse_time_ns, 0u);
+  EXPECT_EQ(compiled_stats.find_variable_calls, 1u);
+  EXPECT_EQ(compiled_stats.sb_values_created, 0u);
+}
+
+TEST_F(InterpreterTest, TestEvaluateExpressionNative) {
+  using Kind = lldb_eval::EvalResult::Kind;
+  lldb::SBError error;
+
+  auto result = lldb_eval::EvaluateExpressionNative(frame_, "a + b", error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::INT32);
+  EXPECT_EQ(result.GetRawBits(), 3u);
+  EXPECT_EQ(result.GetInt64(), 3);
+  EXPECT_STREQ(result.GetType().GetName(), "int");
+  EXPECT_STREQ(result.GetSBValue().GetValue(), "3");
+
+  result = lldb_eval::EvaluateExpressionNative(frame_, "a == 1", error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::BOOL);
+  EXPECT_TRUE(result.GetBool());
+  EXPECT_STREQ(result.GetType().GetName(), "bool");
+  EXPECT_STREQ(result.GetSBValue().GetValue(), "true");
+
+  result = lldb_eval::EvaluateExpressionNative(frame_, "(double)b / 4", error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::DOUBLE);
+  EXPECT_EQ(result.GetDouble(), 0.5);
+  EXPECT_EQ(result.GetInt64(), 0);
+
+  // Variables keep their SBValue, so they are still lvalues.
+  result = lldb_eval::EvaluateExpressionNative(frame_, "b", error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::INT32);
+  EXPECT_EQ(result.GetInt64(), 2);
+  EXPECT_STREQ(result.GetSBValue().GetName(), "b");
+
+  result = lldb_eval::EvaluateExpressionNative(frame_, "&a", error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::POINTER);
+  EXPECT_EQ(result.GetRawBits(), frame_.FindVariable("a").GetLoadAddress());
+  EXPECT_STREQ(result.GetType().GetName(), "int *");
+
+  result = lldb_eval::EvaluateExpressionNative(frame_, "c", error);
+  EXPECT_TRUE(error.Fail());
+  EXPECT_FALSE(result.IsValid());
+
+  // Compiled expressions can produce native results as well.
+  auto expr = lldb_eval::Compile(process_.GetTarget(), "a * 10 + b", error);
+  ASSERT_TRUE(expr.IsValid());
+  result = expr.EvaluateNative(frame_, error);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_EQ(result.kind(), Kind::INT32);
+  EXPECT_EQ(result.GetInt64(), 12);
+}
+
+TEST_F(InterpreterTest, TestMemoryCache) {
+  lldb::SBError error;
+  lldb_eval::EvalStats stats;
+
+  // The elements are next to each other, so they are fetched from the target
+  // at most twice (if they happen to cross the page boundary).
+  lldb::SBValue result = lldb_eval::EvaluateExpression(
+      frame_, "int_arr[0] + int_arr[1] + int_arr[2]", error, &stats);
+  ASSERT_FALSE(error.Fail()) << error.GetCString();
+  EXPECT_STREQ(result.GetValue(), "6");
+
+  EXPECT_EQ(stats.memory_cache_hits + stats.memory_cache_misses, 3u);
+  EXPECT_GE(stats.memory_cache_hits, 1u);
+  EXPECT_EQ(stats.memory_bytes_fetched,
+            stats.memory_cache_misses * lldb_eval::MemoryCache::kPageSize);
+
+  // Reads through pointers and members are cached as well.
+  TestExpr("td_int_ptr[td_int_idx_1] + *td_int_ptr", "3");
+  TestExpr("c_arr[0].field_ + c_arr[1].field_", "1");
+  TestExpr("uint8_arr[uchar_idx]", "'\\xab'");
+}
+
+TEST_F(InterpreterTest, TestConstantFolding) {
+  struct Result {
+    lldb::SBValue value;
+    lldb_eval::EvalErrorCode error;
+    std::string message;
+  };
+  auto evaluate = [this](const std::string& expr, bool fold) {
+    lldb_eval::ExpressionContext expr_ctx(expr,
+                                          lldb::SBExecutionContext(frame_));
+    lldb_eval::Parser p(expr_ctx);
+    lldb_eval::ExprResult tree = p.Run();
+    EXPECT_FALSE(p.HasError()) << p.GetError();
+    if (fold) {
+      tree = lldb_eval::FoldConstants(expr_ctx.GetAstArena(), tree);
+    }
+    lldb_eval::EvalError error;
+    lldb_eval::Interpreter interpreter(expr_ctx);
+    lldb_eval::Value ret = interpreter.Eval(tree, error);
+    return Result{ret.AsSbValue(expr_ctx.GetExecutionContext().GetTarget()),
+                  error.code(), error.message()};
+  };
+
+  // The folded expressions must evaluate to the same values of the same types
+  // and fail with the same errors. These are the expressions of
+  // constant_folding_test.cc with the variables of the frame.
+  const char* expressions[] = {
+      // Arithmetic.
+      "(1 << 12) - 1",
+      "-(2 + 3)",
+      "+(7 % 4) * 2 ^ 1",
+      "0xff & ~0",
+      "1.5 * 2",
+      "4294967295 + 1",
+      "int_max + -1",
+      // Promotion.
+      "1u - 2",
+      "-20LL / 1U",
+      "1ULL << 40",
+      "1.5f + 1",
+      "true + true",
+      "+false",
+      // Logical operators and comparison.
+      "1 == 1.0",
+      "2 < 1 || 3 >= 3",
+      "1 && 0.0",
+      "false && a",
+      "1 || a",
+      "true && a",
+      "a && 1",
+      "(1 > 0) || a",
+      // Ternary operator.
+      "true ? 1 : a",
+      "true ? a : 1",
+      "0 ? a : int_max + (1 + 1)",
+      "a ? 1 + 1 : 2 + 2",
+      // Partial folding.
+      "a + 2 * 3",
+      "a + 2 + 3",
+      "a + (1 << 3)",
+      "(&a)[1 - 1]",
+      "*(&a + (4 - 4))",
+      "(char)(65 + 1)",
+      // Not folded, the errors are reported by the interpreter.
+      "1 / 0",
+      "1 % 0",
+      "(-2147483647 - 1) / -1",
+      "1.5 & 1",
+      "1[2]",
+      "*1",
+      "&1",
+      "1.0 / 0",
+  };
+  for (const char* expr : expressions) {
+    SCOPED_TRACE(expr);
+    Result expected = evaluate(expr, false);
+    Result result = evaluate(expr, true);
+    EXPECT_EQ(result.error, expected.error);
+    EXPECT_EQ(result.message, expected.message);
+    EXPECT_EQ(result.value.IsValid(), expected.value.IsValid());
+    EXPECT_STREQ(result.value.GetValue(), expected.value.GetValue());
+    EXPECT_STREQ(result.value.GetTypeName(), expected.value.GetTypeName());
+  }
+}
+
+TEST_F(InterpreterTest, TestBytecode) {
+  lldb::SBExecutionContext exec_ctx(frame_);
+
+  // The bytecode must produce the same results and errors as the tree walker.
+  const char* expressions[] = {
+      "1 + 2*3",
+      "1 + (2 - 3)",
+      "-20LL / 1ULL",
+      "1 > 0.1",
+      "0 || 1",
+      "1 && 2",
+      "trueVar && (2 < 1)",
+      "falseVar || (2 > 1)",
+      "p_ptr && false",
+      "p_nullptr || true",
+      "falseVar ? 1 : 2.5",
+      "(trueVar || falseVar) ? p_ptr : p_nullptr",
+      "*p_ptr",
+      "(char)trueVar",
+      "true || __doesnt_exist",
+      "false && __doesnt_exist",
+      "true && __doesnt_exist",
+      "s || false",
+      "s ? 1 : 2",
+      "-p_ptr",
+      "!trueVar",
+      "(__doesnt_exist)1",
+  };
+  for (const char* expr : expressions) {
+    SCOPED_TRACE(expr);
+    lldb_eval::ExpressionContext expr_ctx(expr, exec_ctx);
+    lldb_eval::Parser p(expr_ctx);
+    lldb_eval::ExprResult tree = p.Run();
+    ASSERT_FALSE(p.HasError()) << p.GetError();
+
+    lldb_eval::EvalError expected_error;
+    lldb_eval::Interpreter interpreter(expr_ctx);
+    lldb::SBValue expected =
+        interpreter.Eval(tree, expected_error).AsSbValue(exec_ctx.GetTarget());
+
+    lldb_eval::EvalError error;
+    lldb_eval::Bytecode bytecode = lldb_eval::Bytecode::Compile(tree);
+    lldb_eval::VirtualMachine vm(expr_ctx);
+    lldb::SBValue result =
+        vm.Run(bytecode, error).AsSbValue(exec_ctx.GetTarget());
+
+    EXPECT_EQ(error.code(), expected_error.code());
+    EXPECT_EQ(error.message(), expected_error.message());
+    if (!expected_error) {
+      EXPECT_STREQ(result.GetValue(), expected.GetValue());
+      EXPECT_STREQ(result.GetTypeName(), expected.GetTypeName());
+    }
+  }
+}
+
 }  // namespace
@@ -14,30 +14,21 @@
 
 #include "expression_context.h"
 
-#include "clang/Basic/Diagnostic.h"
-#include "clang/Basic/FileManager.h"
-#include "clang/Basic/SourceManager.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "lldb/API/SBExecutionContext.h"
 #include "lldb/API/SBTarget.h"
 #include "lldb/API/SBType.h"
+#include "llvm/ADT/StringRef.h"
+#include "stats.h"
+#include "target_cache.h"
 
-namespace lldb_eval {
-
-ExpressionContext::ExpressionContext(const std::string& expr,
-                                     lldb::SBExecutionContext exec_ctx)
-    : expr_(expr), exec_ctx_(exec_ctx) {
-  // This holds a SourceManager and all of its dependencies.
-  smff_ = std::make_unique<clang::SourceManagerForFile>("<expr>", expr_);
-
-  // Disable default diagnostics reporting.
-  // TODO(werat): Add custom consumer to keep track of errors.
-  clang::DiagnosticsEngine& de = smff_->get().getDiagnostics();
-  de.setClient(new clang::IgnoringDiagConsumer);
-}
-
-lldb::SBType ExpressionContext::ResolveTypeByName(const char* name) {
-  lldb::SBTarget target = exec_ctx_.GetTarget();
+namespace {
 
+lldb::SBType FindTypeByName(lldb::SBTarget target, const char* name) {
   // TODO(b/163308825): Do scope-aware type lookup. Look for the types defined
   // in the current scope (function, class, namespace) and prioritize them.
 
@@ -55,6 +46,9 @@ lldb::SBType ExpressionContext::ResolveTypeByName(const char* name) {
   // in different scopes. I.e. if seaching for "myint", this will also return
   // "ns::myint" and "Foo::myint".
   lldb::SBTypeList types = target.FindTypes(name_ref.data());
+  if (lldb_eval::EvalStats* stats = lldb_eval::GetCurrentStats()) {
+    ++stats->find_types_calls;
+  }
 
   // We've found multiple types, try finding the "correct" one.
   lldb::SBType full_match;
@@ -95,4 +89,34 @@ lldb::SBType ExpressionContext::ResolveTypeByName(const char* name) {
   return lldb::SBType();
 }
 
+}  // namespace
+
+namespace lldb_eval {
+
+ExpressionContext::ExpressionContext(const std::string& expr,
+                                     lldb::SBExecutionContext exec_ctx)
+    : ExpressionContext(expr, exec_ctx,
+                        TargetCache::Get(exec_ctx.GetTarget())) {}
+
+ExpressionContext::ExpressionContext(const std::string& expr,
+                                     lldb::SBExecutionContext exec_ctx,
+                                     std::shared_ptr<TargetCache> target_cache)
+    : expr_(expr),
+      exec_ctx_(exec_ctx),
+      target_cache_(std::move(target_cache)) {}
+
+lldb::SBType ExpressionContext::ResolveTypeByName(const char* name) {
+  lldb::SBType type;
+  if (target_cache_ && target_cache_->LookupType(name, &type)) {
+    return type;
+  }
+
+  // Not found types are cached too, the lookup for them is as expensive.
+  type = FindTypeByName(exec_ctx_.GetTarget(), name);
+  if (target_cache_) {
+    target_cache_->InsertType(name, type);
+  }
+  return type;
+}
+
 }  // namespace lldb_eval
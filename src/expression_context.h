@@ -17,10 +17,14 @@
 #ifndef LLDB_EVAL_EXPRESSION_CONTEXT_H_
 #define LLDB_EVAL_EXPRESSION_CONTEXT_H_
 
-#include "clang/Basic/SourceManager.h"
+#include <memory>
+#include <string>
+
+#include "ast.h"
 #include "lldb/API/SBExecutionContext.h"
 #include "lldb/API/SBType.h"
 #include "scalar.h"
+#include "target_cache.h"
 
 namespace lldb_eval {
 
@@ -28,21 +32,39 @@ class ExpressionContext {
  public:
   ExpressionContext(const std::string& expr, lldb::SBExecutionContext exec_ctx);
 
-  clang::SourceManager& GetSourceManager() const { return smff_->get(); }
+  // Use the given target cache instead of looking it up. This allows to share
+  // the cache lookup between many expressions evaluated in the same target.
+  ExpressionContext(const std::string& expr, lldb::SBExecutionContext exec_ctx,
+                    std::shared_ptr<TargetCache> target_cache);
+
+  // The AST refers to the expression text and the arena, so the context can't
+  // be copied.
+  ExpressionContext(const ExpressionContext&) = delete;
+  ExpressionContext& operator=(const ExpressionContext&) = delete;
+
+  const std::string& GetExpr() const { return expr_; }
+  AstArena& GetAstArena() { return arena_; }
   lldb::SBExecutionContext GetExecutionContext() const { return exec_ctx_; }
+  std::shared_ptr<TargetCache> GetTargetCache() const { return target_cache_; }
 
  public:
   lldb::SBType ResolveTypeByName(const char* name);
 
  private:
-  // Store the expression, since SourceManager doesn't take the ownership.
+  // Store the expression, since the lexer doesn't take the ownership.
   std::string expr_;
-  std::unique_ptr<clang::SourceManagerForFile> smff_;
+
+  // Memory of the AST produced by the parser.
+  AstArena arena_;
 
   // The expression exists in the context of an LLDB target. Execution context
   // provides information for semantic analysis (e.g. resolving types, looking
   // up variables, etc).
   lldb::SBExecutionContext exec_ctx_;
+
+  // Lookup results shared with other expressions in the same target. Can be
+  // nullptr if there is no target.
+  std::shared_ptr<TargetCache> target_cache_;
 };
 
 }  // namespace lldb_eval
@@ -0,0 +1,77 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "frame_variables.h"
+
+#include <string>
+
+#include "api.h"
+#include "lldb/API/SBFrame.h"
+#include "lldb/API/SBValue.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "stats.h"
+
+namespace {
+
+thread_local lldb_eval::FrameVariables* current_variables = nullptr;
+
+}  // namespace
+
+namespace lldb_eval {
+
+FrameVariables::FrameVariables(lldb::SBFrame frame)
+    : frame_(frame), has_this_(false) {}
+
+lldb::SBValue FrameVariables::Find(llvm::StringRef name) {
+  auto it = variables_.find(name);
+  if (it != variables_.end()) {
+    return it->second;
+  }
+
+  EvalStats* stats = GetCurrentStats();
+  std::string name_str = name.str();
+
+  // Try looking for a local variable in current scope.
+  lldb::SBValue value = frame_.FindVariable(name_str.c_str());
+  if (stats) {
+    ++stats->find_variable_calls;
+  }
+
+  // Try looking for an instance variable (class member).
+  if (!value) {
+    if (!has_this_) {
+      this_ = frame_.FindVariable("this");
+      has_this_ = true;
+      if (stats) {
+        ++stats->find_variable_calls;
+      }
+    }
+    value = this_.GetChildMemberWithName(name_str.c_str());
+  }
+
+  variables_.try_emplace(name, value);
+  return value;
+}
+
+FrameVariablesScope::FrameVariablesScope(FrameVariables* variables)
+    : previous_(current_variables) {
+  current_variables = variables;
+}
+
+FrameVariablesScope::~FrameVariablesScope() { current_variables = previous_; }
+
+FrameVariables* GetCurrentFrameVariables() { return current_variables; }
+
+}  // namespace lldb_eval
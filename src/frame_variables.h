@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_FRAME_VARIABLES_H_
+#define LLDB_EVAL_FRAME_VARIABLES_H_
+
+#include "lldb/API/SBFrame.h"
+#include "lldb/API/SBValue.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace lldb_eval {
+
+// Variables visible in a frame, i.e. the locals, the arguments and the members
+// of `this`, by name. Every name is looked up in the frame only once and the
+// result (including a miss) is kept, so a batch of expressions over the same
+// frame walks the block scopes once per identifier rather than once per use.
+// The map is filled lazily and is valid only while the process is stopped.
+class FrameVariables {
+ public:
+  explicit FrameVariables(lldb::SBFrame frame);
+
+  FrameVariables(const FrameVariables&) = delete;
+  FrameVariables& operator=(const FrameVariables&) = delete;
+
+  lldb::SBFrame frame() const { return frame_; }
+
+  // Returns the local variable or the instance variable (member of `this`)
+  // with the given name. The returned value is not valid if there is none.
+  lldb::SBValue Find(llvm::StringRef name);
+
+ private:
+  lldb::SBFrame frame_;
+  // The "this" pointer, looked up on the first miss among the locals.
+  lldb::SBValue this_;
+  bool has_this_;
+  llvm::StringMap<lldb::SBValue> variables_;
+};
+
+// Makes the evaluations running on the current thread resolve the identifiers
+// through `variables` until the end of the scope. The evaluations in other
+// frames than the one of `variables` don't use it.
+class FrameVariablesScope {
+ public:
+  explicit FrameVariablesScope(FrameVariables* variables);
+  ~FrameVariablesScope();
+
+  FrameVariablesScope(const FrameVariablesScope&) = delete;
+  FrameVariablesScope& operator=(const FrameVariablesScope&) = delete;
+
+ private:
+  FrameVariables* previous_;
+};
+
+// Returns the frame variables of the current evaluation, or nullptr if there
+// are none.
+FrameVariables* GetCurrentFrameVariables();
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_FRAME_VARIABLES_H_
@@ -0,0 +1,461 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lexer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TokenKinds.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Lex/Token.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace {
+
+// Maximum number of expressions added to a single source manager before it's
+// re-created.
+const size_t kMaxSourcesPerSourceManager = 1024;
+
+bool IsNewLine(char c) { return c == '\n' || c == '\r'; }
+
+// Returns the offset of the `eof` token. Following clang::Preprocessor, `eof`
+// points to the last line of the expression, i.e. the trailing newline is
+// ignored.
+size_t GetEofOffset(llvm::StringRef expr) {
+  size_t offset = expr.size();
+  if (offset > 0 && IsNewLine(expr[offset - 1])) {
+    --offset;
+    // Handle "\r\n" and "\n\r".
+    if (offset > 0 && IsNewLine(expr[offset - 1]) &&
+        expr[offset - 1] != expr[offset]) {
+      --offset;
+    }
+  }
+  return offset;
+}
+
+bool IsIdentifierHead(char c, bool allow_dollar) {
+  return clang::isLetter(c) || c == '_' || (allow_dollar && c == '$');
+}
+
+bool IsIdentifierBody(char c, bool allow_dollar) {
+  return IsIdentifierHead(c, allow_dollar) || clang::isDigit(c);
+}
+
+// Returns true if the builtin lexer can handle the expression.
+bool CanUseBuiltinLexer(llvm::StringRef expr) {
+  for (size_t i = 0; i < expr.size(); ++i) {
+    char c = expr[i];
+    if (!clang::isASCII(c) || c == '\0' || c == '\\' || c == '\'' ||
+        c == '"') {
+      return false;
+    }
+    if (c == '/' && i + 1 < expr.size() &&
+        (expr[i + 1] == '/' || expr[i + 1] == '*')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the length of the preprocessing number at the beginning of `text`.
+size_t GetNumberLength(llvm::StringRef text) {
+  // Same as clang without C99: the binary exponent "p" can have a sign only in
+  // the hexadecimal literals, e.g. "1p+2" is "1p", "+" and "2".
+  bool is_hex = text.startswith("0x") || text.startswith("0X");
+  size_t length = 1;
+  char prev = text[0];
+  while (length < text.size()) {
+    char c = text[length];
+    // Exponent sign is a part of the number, e.g. "1e+10" or "0x1p-3".
+    bool is_binary_exponent = is_hex && (prev == 'p' || prev == 'P');
+    bool is_exponent_sign = (c == '+' || c == '-') &&
+                            (prev == 'e' || prev == 'E' || is_binary_exponent);
+    if (!clang::isPreprocessingNumberBody(c) && !is_exponent_sign) {
+      break;
+    }
+    prev = c;
+    ++length;
+  }
+  return length;
+}
+
+// Matches the longest punctuator at the beginning of `text`. Returns
+// `tok::unknown` and the length of one if there is no such punctuator.
+clang::tok::TokenKind GetPunctuator(llvm::StringRef text, size_t* length) {
+  auto next = [text](size_t i) { return i < text.size() ? text[i] : '\0'; };
+
+  *length = 1;
+  switch (text[0]) {
+    case '[':
+      return clang::tok::l_square;
+    case ']':
+      return clang::tok::r_square;
+    case '(':
+      return clang::tok::l_paren;
+    case ')':
+      return clang::tok::r_paren;
+    case '{':
+      return clang::tok::l_brace;
+    case '}':
+      return clang::tok::r_brace;
+    case '?':
+      return clang::tok::question;
+    case '~':
+      return clang::tok::tilde;
+    case ';':
+      return clang::tok::semi;
+    case ',':
+      return clang::tok::comma;
+    case '.':
+      if (next(1) == '*') {
+        *length = 2;
+        return clang::tok::periodstar;
+      }
+      if (next(1) == '.' && next(2) == '.') {
+        *length = 3;
+        return clang::tok::ellipsis;
+      }
+      return clang::tok::period;
+    case '&':
+      if (next(1) == '&') {
+        *length = 2;
+        return clang::tok::ampamp;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::ampequal;
+      }
+      return clang::tok::amp;
+    case '*':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::starequal;
+      }
+      return clang::tok::star;
+    case '+':
+      if (next(1) == '+') {
+        *length = 2;
+        return clang::tok::plusplus;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::plusequal;
+      }
+      return clang::tok::plus;
+    case '-':
+      if (next(1) == '-') {
+        *length = 2;
+        return clang::tok::minusminus;
+      }
+      if (next(1) == '>' && next(2) == '*') {
+        *length = 3;
+        return clang::tok::arrowstar;
+      }
+      if (next(1) == '>') {
+        *length = 2;
+        return clang::tok::arrow;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::minusequal;
+      }
+      return clang::tok::minus;
+    case '!':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::exclaimequal;
+      }
+      return clang::tok::exclaim;
+    case '/':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::slashequal;
+      }
+      return clang::tok::slash;
+    case '%':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::percentequal;
+      }
+      return clang::tok::percent;
+    case '<':
+      if (next(1) == '<' && next(2) == '=') {
+        *length = 3;
+        return clang::tok::lesslessequal;
+      }
+      if (next(1) == '<') {
+        *length = 2;
+        return clang::tok::lessless;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::lessequal;
+      }
+      return clang::tok::less;
+    case '>':
+      if (next(1) == '>' && next(2) == '=') {
+        *length = 3;
+        return clang::tok::greatergreaterequal;
+      }
+      if (next(1) == '>') {
+        *length = 2;
+        return clang::tok::greatergreater;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::greaterequal;
+      }
+      return clang::tok::greater;
+    case '^':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::caretequal;
+      }
+      return clang::tok::caret;
+    case '|':
+      if (next(1) == '|') {
+        *length = 2;
+        return clang::tok::pipepipe;
+      }
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::pipeequal;
+      }
+      return clang::tok::pipe;
+    case ':':
+      if (next(1) == ':') {
+        *length = 2;
+        return clang::tok::coloncolon;
+      }
+      return clang::tok::colon;
+    case '=':
+      if (next(1) == '=') {
+        *length = 2;
+        return clang::tok::equalequal;
+      }
+      return clang::tok::equal;
+    case '#':
+      if (next(1) == '#') {
+        *length = 2;
+        return clang::tok::hashhash;
+      }
+      return clang::tok::hash;
+    default:
+      return clang::tok::unknown;
+  }
+}
+
+}  // namespace
+
+namespace lldb_eval {
+
+LexerEnvironment& LexerEnvironment::GetForCurrentThread() {
+  static thread_local LexerEnvironment env;
+  return env;
+}
+
+LexerEnvironment::LexerEnvironment() : num_sources_(0), active_sources_(0) {
+  // Disable default diagnostics reporting.
+  // TODO(werat): Add custom consumer to keep track of errors.
+  de_ = std::make_unique<clang::DiagnosticsEngine>(
+      new clang::DiagnosticIDs, new clang::DiagnosticOptions,
+      new clang::IgnoringDiagConsumer);
+
+  fm_ = std::make_unique<clang::FileManager>(clang::FileSystemOptions());
+
+  auto tOpts = std::make_shared<clang::TargetOptions>();
+  tOpts->Triple = llvm::sys::getDefaultTargetTriple();
+
+  ti_.reset(clang::TargetInfo::CreateTargetInfo(*de_, tOpts));
+
+  lang_opts_ = std::make_unique<clang::LangOptions>();
+  lang_opts_->Bool = true;
+  lang_opts_->WChar = true;
+  lang_opts_->CPlusPlus = true;
+  lang_opts_->CPlusPlus11 = true;
+  lang_opts_->CPlusPlus14 = true;
+  lang_opts_->CPlusPlus17 = true;
+
+  // Identifier table knows about the keywords enabled by the language options.
+  identifiers_ = std::make_unique<clang::IdentifierTable>(*lang_opts_);
+
+  ResetSourceManager();
+}
+
+void LexerEnvironment::ResetSourceManager() {
+  pp_.reset();
+  hs_.reset();
+  sm_.reset();
+  de_->Reset();
+
+  sm_ = std::make_unique<clang::SourceManager>(*de_, *fm_);
+
+  auto hOpts = std::make_shared<clang::HeaderSearchOptions>();
+  hs_ = std::make_unique<clang::HeaderSearch>(hOpts, *sm_, *de_, *lang_opts_,
+                                              ti_.get());
+
+  auto pOpts = std::make_shared<clang::PreprocessorOptions>();
+  pp_ = std::make_unique<clang::Preprocessor>(pOpts, *de_, *lang_opts_, *sm_,
+                                              *hs_, tml_);
+  pp_->Initialize(*ti_);
+
+  num_sources_ = 0;
+}
+
+void LexerEnvironment::Lex(const std::string& expr,
+                           std::vector<clang::Token>* tokens, LexerKind kind) {
+  // The source manager can be re-created only if nobody refers to it.
+  if (active_sources_ == 0 && num_sources_ >= kMaxSourcesPerSourceManager) {
+    ResetSourceManager();
+  }
+  ++num_sources_;
+  ++active_sources_;
+
+  // Source manager doesn't take the ownership of the expression, the buffer
+  // just refers to it.
+  clang::FileID fid = sm_->createFileID(
+      llvm::MemoryBuffer::getMemBuffer(expr, "<expr>"));
+  clang::SourceLocation start_loc = sm_->getLocForStartOfFile(fid);
+
+  // There can't be more tokens than characters (plus `eof`).
+  tokens->reserve(tokens->size() + expr.size() + 1);
+
+  if (kind == LexerKind::BUILTIN && CanUseBuiltinLexer(expr)) {
+    LexWithBuiltinLexer(expr, start_loc, tokens);
+  } else {
+    LexWithClangLexer(expr, start_loc, tokens);
+  }
+}
+
+void LexerEnvironment::LexWithClangLexer(const std::string& expr,
+                                         clang::SourceLocation start_loc,
+                                         std::vector<clang::Token>* tokens) {
+  const char* begin = expr.data();
+  const char* end = begin + expr.size();
+
+  // Lexer in the "raw" mode doesn't need the preprocessor and doesn't do any
+  // preprocessing, which is not needed for the expressions anyway.
+  clang::Lexer lexer(start_loc, *lang_opts_, begin, begin, end);
+
+  clang::Token token;
+  do {
+    lexer.LexFromRawLexer(token);
+
+    if (token.is(clang::tok::raw_identifier)) {
+      LookUpIdentifier(token);
+    }
+    if (token.is(clang::tok::eof)) {
+      token.setLocation(start_loc.getLocWithOffset(
+          static_cast<int>(GetEofOffset(expr))));
+    }
+
+    tokens->push_back(token);
+  } while (token.isNot(clang::tok::eof));
+}
+
+void LexerEnvironment::LexWithBuiltinLexer(const std::string& expr,
+                                           clang::SourceLocation start_loc,
+                                           std::vector<clang::Token>* tokens) {
+  llvm::StringRef text(expr);
+  size_t offset = 0;
+
+  while (true) {
+    // Skip the whitespaces.
+    while (offset < text.size() && clang::isWhitespace(text[offset])) {
+      ++offset;
+    }
+    if (offset == text.size()) {
+      break;
+    }
+
+    llvm::StringRef rest = text.drop_front(offset);
+    char c = rest[0];
+    size_t length;
+
+    clang::Token token;
+    token.startToken();
+    token.setLocation(start_loc.getLocWithOffset(static_cast<int>(offset)));
+
+    if (IsIdentifierHead(c, lang_opts_->DollarIdents)) {
+      length = 1;
+      while (length < rest.size() &&
+             IsIdentifierBody(rest[length], lang_opts_->DollarIdents)) {
+        ++length;
+      }
+      clang::IdentifierInfo* ii = &identifiers_->get(rest.take_front(length));
+      token.setIdentifierInfo(ii);
+      token.setKind(ii->getTokenID());
+
+    } else if (clang::isDigit(c) ||
+               (c == '.' && rest.size() > 1 && clang::isDigit(rest[1]))) {
+      length = GetNumberLength(rest);
+      token.setKind(clang::tok::numeric_constant);
+      token.setLiteralData(rest.data());
+
+    } else {
+      token.setKind(GetPunctuator(rest, &length));
+    }
+
+    token.setLength(static_cast<unsigned>(length));
+    tokens->push_back(token);
+    offset += length;
+  }
+
+  clang::Token eof;
+  eof.startToken();
+  eof.setKind(clang::tok::eof);
+  eof.setLocation(
+      start_loc.getLocWithOffset(static_cast<int>(GetEofOffset(text))));
+  tokens->push_back(eof);
+}
+
+void LexerEnvironment::ReleaseSource() {
+  assert(active_sources_ > 0 && "Unbalanced call to ReleaseSource()");
+  --active_sources_;
+}
+
+std::string LexerEnvironment::GetSpelling(const clang::Token& token) const {
+  return clang::Lexer::getSpelling(token, *sm_, *lang_opts_);
+}
+
+void LexerEnvironment::LookUpIdentifier(clang::Token& token) {
+  // Turn the raw identifier into an identifier or a keyword.
+  clang::IdentifierInfo* ii;
+  if (!token.needsCleaning() && !token.hasUCN()) {
+    ii = &identifiers_->get(token.getRawIdentifier());
+  } else {
+    ii = &identifiers_->get(GetSpelling(token));
+  }
+  token.setIdentifierInfo(ii);
+  token.setKind(ii->getTokenID());
+}
+
+}  // namespace lldb_eval
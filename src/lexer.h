@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_LEXER_H_
+#define LLDB_EVAL_LEXER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceLocation.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/ModuleLoader.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Token.h"
+
+namespace lldb_eval {
+
+enum class LexerKind {
+  // clang::Lexer in the "raw" mode.
+  CLANG,
+  // Hand-written lexer for the expression grammar (docs/expr-lang.ebnf). It
+  // produces the same tokens as CLANG, but falls back to it for the things it
+  // doesn't handle: comments, character and string literals, escaped newlines
+  // and non-ASCII characters.
+  BUILTIN,
+};
+
+// Long-lived state required for lexing the expressions: diagnostics engine,
+// target info, language options, identifier table, etc. Creating it is way more
+// expensive than lexing a typical expression, so there is a single instance per
+// thread, which is shared by all parsers running on that thread.
+class LexerEnvironment {
+ public:
+  // Returns the environment of the current thread, creates it on first use.
+  static LexerEnvironment& GetForCurrentThread();
+
+  // Adds the expression to the source manager and splits it into tokens. The
+  // last token is always `eof`. The expression must outlive the tokens. The
+  // source locations of the tokens are valid until the matching call to
+  // `ReleaseSource()`.
+  void Lex(const std::string& expr, std::vector<clang::Token>* tokens,
+           LexerKind kind = LexerKind::CLANG);
+  void ReleaseSource();
+
+  std::string GetSpelling(const clang::Token& token) const;
+
+  clang::SourceManager& GetSourceManager() const { return *sm_; }
+  clang::DiagnosticsEngine& GetDiagnostics() const { return *de_; }
+  const clang::LangOptions& GetLangOpts() const { return *lang_opts_; }
+  const clang::TargetInfo& GetTargetInfo() const { return *ti_; }
+  clang::Preprocessor& GetPreprocessor() const { return *pp_; }
+
+ private:
+  LexerEnvironment();
+
+  void ResetSourceManager();
+  void LexWithClangLexer(const std::string& expr,
+                         clang::SourceLocation start_loc,
+                         std::vector<clang::Token>* tokens);
+  void LexWithBuiltinLexer(const std::string& expr,
+                           clang::SourceLocation start_loc,
+                           std::vector<clang::Token>* tokens);
+  void LookUpIdentifier(clang::Token& token);
+
+ private:
+  std::unique_ptr<clang::DiagnosticsEngine> de_;
+  std::unique_ptr<clang::FileManager> fm_;
+  std::unique_ptr<clang::TargetInfo> ti_;
+  std::unique_ptr<clang::LangOptions> lang_opts_;
+  std::unique_ptr<clang::IdentifierTable> identifiers_;
+  clang::TrivialModuleLoader tml_;
+
+  // Source manager never frees the buffers added to it, so it is re-created
+  // (together with everything that depends on it) after a certain number of
+  // expressions. Preprocessor isn't used for lexing, but older versions of
+  // clang::NumericLiteralParser require it.
+  std::unique_ptr<clang::SourceManager> sm_;
+  std::unique_ptr<clang::HeaderSearch> hs_;
+  std::unique_ptr<clang::Preprocessor> pp_;
+
+  // Number of expressions added to the current source manager.
+  size_t num_sources_;
+  // Number of expressions, which tokens are still in use.
+  size_t active_sources_;
+};
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_LEXER_H_
@@ -0,0 +1,137 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lexer.h"
+
+#include <string>
+#include <vector>
+
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TokenKinds.h"
+#include "clang/Lex/Token.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using lldb_eval::LexerEnvironment;
+using lldb_eval::LexerKind;
+
+// Expressions used to compare the builtin lexer against the clang one.
+const char* kCorpus[] = {
+    // Empty expressions.
+    "",
+    "   ",
+    "\n",
+    " \t\f\v\r\n",
+    // Identifiers and keywords.
+    "a",
+    "foo_bar1 _baz __x",
+    "$var $1 a$b $",
+    "true false this sizeof",
+    "int char bool short long signed unsigned float double void",
+    "const volatile wchar_t char16_t char32_t",
+    "nullptr static_cast new delete operator",
+    // Numbers.
+    "0 1 42 1234567890",
+    "0x1F 0XabCd 0b101 0777",
+    "1u 1U 1l 1L 1ul 1ull 1LLU 1i64",
+    "1.5 .5 1. 1.5f 1.5L 1e10 1E-10 1e+10f",
+    "0x1p3 0x1P-3 0x1.8p+1",
+    "1p+2 1P-3 0x1p+2 1.5p-1 .5p+1 0X1P+2",
+    "0x1e+1 1..2 1.2.3 1e 1abc 1_000",
+    "a.5 a.b .5.a",
+    // Punctuators.
+    "[ ] ( ) { } . ... -> ->* .*",
+    "& && &= * *= + ++ += - -- -= ~ ! !=",
+    "/ /= % %= < << <<= <= > >> >>= >=",
+    "^ ^= | || |= ? : :: ; = == , # ##",
+    "<<<= >>>= ---> ++++ &&& ||| :::",
+    "....  .. a..b a...b",
+    "<=> <: :> <% %> %: %:%:",
+    // Unknown characters.
+    "@ ` a@b",
+    // Expressions.
+    "1 + 2 * (4 - 5) + 6 / 3 - (7 % 8)",
+    "1 || 2 && 3 >> 4 << 5 * (7 ^ 8)",
+    "foo->bar.baz",
+    "(char)(int)1",
+    "(::ns::inner::mydouble)myint_ + a * 2",
+    "(T_1<T_1<int*>>::myint)1 + c_arr[1].field_",
+    "p == nullptr ? *ap : -na",
+    "1 + 2 +\n3 + 4 +\n5 + 6 +\n",
+    "a\r\nb\r\n",
+    "a\n\r",
+    // Fallback to clang::Lexer.
+    "'a' + 1",
+    "\"hello\"",
+    "u8\"hello\" L'a'",
+    "1'000'000",
+    "a // comment",
+    "a /* comment */ + b",
+    "a //* comment */ b",
+    "a \\\n+ b",
+    "\\u00e9",
+    "\xd0\xb0 + 1",
+};
+
+std::vector<clang::Token> Lex(const std::string& expr, LexerKind kind) {
+  std::vector<clang::Token> tokens;
+  LexerEnvironment::GetForCurrentThread().Lex(expr, &tokens, kind);
+  return tokens;
+}
+
+TEST(LexerTest, TestBuiltinLexerParity) {
+  LexerEnvironment& env = LexerEnvironment::GetForCurrentThread();
+
+  for (const char* expr : kCorpus) {
+    SCOPED_TRACE(std::string("[lexing expr]: ") + expr);
+
+    auto expected = Lex(expr, LexerKind::CLANG);
+    auto actual = Lex(expr, LexerKind::BUILTIN);
+    clang::SourceManager& sm = env.GetSourceManager();
+
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      SCOPED_TRACE("[token]: " + std::to_string(i));
+
+      EXPECT_EQ(clang::tok::getTokenName(expected[i].getKind()),
+                clang::tok::getTokenName(actual[i].getKind()));
+      EXPECT_EQ(sm.getFileOffset(expected[i].getLocation()),
+                sm.getFileOffset(actual[i].getLocation()));
+      EXPECT_EQ(expected[i].getLength(), actual[i].getLength());
+      EXPECT_EQ(expected[i].getIdentifierInfo(),
+                actual[i].getIdentifierInfo());
+      EXPECT_EQ(env.GetSpelling(expected[i]), env.GetSpelling(actual[i]));
+    }
+
+    env.ReleaseSource();
+    env.ReleaseSource();
+  }
+}
+
+TEST(LexerTest, TestEofLocation) {
+  LexerEnvironment& env = LexerEnvironment::GetForCurrentThread();
+
+  for (LexerKind kind : {LexerKind::CLANG, LexerKind::BUILTIN}) {
+    auto tokens = Lex("1 + 2\n", kind);
+    clang::SourceManager& sm = env.GetSourceManager();
+    ASSERT_EQ(tokens.size(), 4u);
+    EXPECT_TRUE(tokens.back().is(clang::tok::eof));
+    // `eof` points to the end of the last line, not past the trailing newline.
+    EXPECT_EQ(sm.getFileOffset(tokens.back().getLocation()), 5u);
+    env.ReleaseSource();
+  }
+}
+
+}  // namespace
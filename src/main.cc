@@ -66,7 +66,7 @@ int main(int argc, char** argv) {
   lldb_eval::Interpreter eval(expr_ctx);
 
   lldb_eval::EvalError error;
-  lldb_eval::Value result = eval.Eval(expr_result.get(), error);
+  lldb_eval::Value result = eval.Eval(expr_result, error);
 
   auto time_eval = std::chrono::high_resolution_clock::now();
 
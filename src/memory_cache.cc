@@ -0,0 +1,130 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "memory_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "api.h"
+#include "lldb/API/SBData.h"
+#include "lldb/API/SBError.h"
+#include "lldb/API/SBProcess.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-defines.h"
+#include "lldb/lldb-types.h"
+#include "read_set.h"
+#include "stats.h"
+
+namespace {
+
+thread_local lldb_eval::MemoryCache* current_cache = nullptr;
+
+}  // namespace
+
+namespace lldb_eval {
+
+constexpr size_t MemoryCache::kPageSize;
+
+MemoryCache::MemoryCache(lldb::SBProcess process)
+    : process_(process), stop_id_(0), has_stop_id_(false) {}
+
+bool MemoryCache::Read(lldb::addr_t addr, void* buf, size_t size) {
+  uint32_t stop_id = process_.GetStopID();
+  if (!has_stop_id_ || stop_id != stop_id_) {
+    pages_.clear();
+    stop_id_ = stop_id;
+    has_stop_id_ = true;
+  }
+
+  uint8_t* out = static_cast<uint8_t*>(buf);
+  while (size > 0) {
+    lldb::addr_t page_addr = addr - addr % kPageSize;
+    size_t offset = static_cast<size_t>(addr - page_addr);
+    size_t chunk = std::min(size, kPageSize - offset);
+
+    const std::vector<uint8_t>& page = GetPage(page_addr);
+    if (offset + chunk > page.size()) {
+      return false;
+    }
+    memcpy(out, page.data() + offset, chunk);
+
+    out += chunk;
+    addr += chunk;
+    size -= chunk;
+  }
+  return true;
+}
+
+const std::vector<uint8_t>& MemoryCache::GetPage(lldb::addr_t page_addr) {
+  EvalStats* stats = GetCurrentStats();
+
+  auto it = pages_.find(page_addr);
+  if (it != pages_.end()) {
+    if (stats) {
+      ++stats->memory_cache_hits;
+    }
+    return it->second;
+  }
+
+  std::vector<uint8_t>& page = pages_[page_addr];
+  page.resize(kPageSize);
+  lldb::SBError error;
+  size_t bytes_read =
+      process_.ReadMemory(page_addr, page.data(), kPageSize, error);
+  // Failed reads are cached as well, the caller falls back to LLDB.
+  page.resize(error.Fail() ? 0 : bytes_read);
+
+  if (stats) {
+    ++stats->memory_cache_misses;
+    stats->memory_bytes_fetched += page.size();
+  }
+  return page;
+}
+
+MemoryCacheScope::MemoryCacheScope(MemoryCache* cache)
+    : previous_(current_cache) {
+  current_cache = cache;
+}
+
+MemoryCacheScope::~MemoryCacheScope() { current_cache = previous_; }
+
+MemoryCache* GetCurrentMemoryCache() { return current_cache; }
+
+lldb::SBData ReadValueData(lldb::SBValue value) {
+  RecordValueRead(value);
+
+  if (current_cache) {
+    lldb::addr_t addr = value.GetLoadAddress();
+    size_t size = value.GetByteSize();
+
+    // Only the scalars and the pointers are read this way, so the value fits
+    // into a single uint64_t. The bytes are copied as they are in the target
+    // memory, so they are decoded with the byte order of the process.
+    uint64_t bytes = 0;
+    if (addr != LLDB_INVALID_ADDRESS && size <= sizeof(bytes) &&
+        current_cache->Read(addr, &bytes, size)) {
+      TrackRead(addr, &bytes, size);
+      lldb::SBProcess process = value.GetProcess();
+      return lldb::SBData::CreateDataFromUInt64Array(
+          process.GetByteOrder(), process.GetAddressByteSize(), &bytes, 1);
+    }
+  }
+
+  TrackRead(value);
+  return value.GetData();
+}
+
+}  // namespace lldb_eval
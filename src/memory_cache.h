@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_MEMORY_CACHE_H_
+#define LLDB_EVAL_MEMORY_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lldb/API/SBData.h"
+#include "lldb/API/SBProcess.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-types.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace lldb_eval {
+
+// Caches the memory of the process in pages, so reading overlapping or nearby
+// values (e.g. "a[i].x + a[i].y") goes to the target only once. On remote
+// targets every read is a round trip to the debug server. The cache is dropped
+// when the process resumes, i.e. when its stop ID changes.
+class MemoryCache {
+ public:
+  static constexpr size_t kPageSize = 512;
+
+  explicit MemoryCache(lldb::SBProcess process);
+
+  MemoryCache(const MemoryCache&) = delete;
+  MemoryCache& operator=(const MemoryCache&) = delete;
+
+  // Copies `size` bytes at `addr` to `buf`. Returns false if some of the bytes
+  // can't be read, the contents of `buf` are unspecified then.
+  bool Read(lldb::addr_t addr, void* buf, size_t size);
+
+ private:
+  // Returns the page starting at `page_addr`, fetches it if necessary. The
+  // page can be shorter than `kPageSize` if the end of it is not readable.
+  const std::vector<uint8_t>& GetPage(lldb::addr_t page_addr);
+
+  lldb::SBProcess process_;
+  uint32_t stop_id_;
+  bool has_stop_id_;
+  llvm::DenseMap<lldb::addr_t, std::vector<uint8_t>> pages_;
+};
+
+// Makes the reads of the evaluation running on the current thread go through
+// `cache` until the end of the scope.
+class MemoryCacheScope {
+ public:
+  explicit MemoryCacheScope(MemoryCache* cache);
+  ~MemoryCacheScope();
+
+  MemoryCacheScope(const MemoryCacheScope&) = delete;
+  MemoryCacheScope& operator=(const MemoryCacheScope&) = delete;
+
+ private:
+  MemoryCache* previous_;
+};
+
+// Returns the memory cache of the current evaluation, or nullptr if there is
+// none.
+MemoryCache* GetCurrentMemoryCache();
+
+// Returns the data of `value`. Values located in the target memory are read
+// through the current memory cache, others (e.g. values in registers) are read
+// by LLDB.
+lldb::SBData ReadValueData(lldb::SBValue value);
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_MEMORY_CACHE_H_
@@ -21,25 +21,17 @@
 #include <string>
 
 #include "ast.h"
-#include "clang/Basic/Diagnostic.h"
-#include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceManager.h"
-#include "clang/Basic/TargetInfo.h"
-#include "clang/Basic/TargetOptions.h"
 #include "clang/Basic/TokenKinds.h"
-#include "clang/Lex/HeaderSearch.h"
-#include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LiteralSupport.h"
-#include "clang/Lex/ModuleLoader.h"
-#include "clang/Lex/Preprocessor.h"
-#include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Lex/Token.h"
 #include "defines.h"
+#include "lexer.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FormatAdapters.h"
 #include "llvm/Support/FormatVariadic.h"
-#include "llvm/Support/Host.h"
 #include "scalar.h"
 
 #define TYPE_WIDTH(type) static_cast<unsigned>(sizeof(type)) * 8
@@ -136,39 +128,20 @@ IntegerType PickIntegerType(const clang::NumericLiteralParser& literal,
 
 namespace lldb_eval {
 
-Parser::Parser(ExpressionContext& expr_ctx) : expr_ctx_(&expr_ctx) {
-  clang::SourceManager& sm = expr_ctx_->GetSourceManager();
-  clang::DiagnosticsEngine& de = sm.getDiagnostics();
-
-  auto tOpts = std::make_shared<clang::TargetOptions>();
-  tOpts->Triple = llvm::sys::getDefaultTargetTriple();
-
-  ti_.reset(clang::TargetInfo::CreateTargetInfo(de, tOpts));
-
-  lang_opts_ = std::make_unique<clang::LangOptions>();
-  lang_opts_->Bool = true;
-  lang_opts_->WChar = true;
-  lang_opts_->CPlusPlus = true;
-  lang_opts_->CPlusPlus11 = true;
-  lang_opts_->CPlusPlus14 = true;
-  lang_opts_->CPlusPlus17 = true;
-
-  tml_ = std::make_unique<clang::TrivialModuleLoader>();
-
-  auto hOpts = std::make_shared<clang::HeaderSearchOptions>();
-  hs_ = std::make_unique<clang::HeaderSearch>(hOpts, sm, de, *lang_opts_,
-                                              ti_.get());
-
-  auto pOpts = std::make_shared<clang::PreprocessorOptions>();
-  pp_ = std::make_unique<clang::Preprocessor>(pOpts, de, *lang_opts_, sm, *hs_,
-                                              *tml_);
-  pp_->Initialize(*ti_);
-  pp_->EnterMainSourceFile();
+Parser::Parser(ExpressionContext& expr_ctx, LexerKind lexer_kind)
+    : expr_ctx_(&expr_ctx),
+      has_error_(false),
+      env_(&LexerEnvironment::GetForCurrentThread()),
+      next_token_(0) {
+  // The whole expression is lexed upfront, parser just walks the tokens.
+  env_->Lex(expr_ctx_->GetExpr(), &tokens_, lexer_kind);
 
   // Initialize the token.
   token_.setKind(clang::tok::unknown);
 }
 
+Parser::~Parser() { env_->ReleaseSource(); }
+
 ExprResult Parser::Run() {
   ConsumeToken();
   auto expr = ParseExpression();
@@ -177,7 +150,7 @@ ExprResult Parser::Run() {
   // Explicitly return ErrorNode if there was an error during the parsing. Some
   // routines raise an error, but don't change the return value (e.g. Expect).
   if (HasError()) {
-    return std::make_unique<ErrorNode>();
+    return MakeNode<ErrorNode>();
   }
   return expr;
 }
@@ -188,20 +161,50 @@ void Parser::ConsumeToken() {
     // occurred during parsing and we're trying to bail out.
     return;
   }
-  pp_->Lex(token_);
+  // The last token is always eof, so we never go past the end.
+  token_ = tokens_[next_token_++];
+}
+
+llvm::StringRef Parser::GetTokenText(const clang::Token& token) {
+  // Most of the tokens are spelled exactly as in the expression, refer to the
+  // expression text directly instead of making a copy.
+  if (!token.needsCleaning()) {
+    clang::SourceManager& sm = env_->GetSourceManager();
+    unsigned offset = sm.getFileOffset(token.getLocation());
+    return llvm::StringRef(expr_ctx_->GetExpr())
+        .substr(offset, token.getLength());
+  }
+  return expr_ctx_->GetAstArena().CopyString(env_->GetSpelling(token));
+}
+
+const Parser::Error& Parser::GetError() {
+  if (has_error_ && error_.empty()) {
+    // The source locations are valid until the parser is destroyed.
+    error_ = FormatDiagnostics(env_->GetSourceManager(), error_message_,
+                               error_loc_);
+  }
+  return error_;
 }
 
 void Parser::BailOut(const std::string& error, clang::SourceLocation loc) {
-  if (!error_.empty()) {
+  if (has_error_) {
     // If error is already set, then the parser is in the "bail-out" mode. Don't
     // do anything and keep the original error.
     return;
   }
 
-  error_ = FormatDiagnostics(expr_ctx_->GetSourceManager(), error, loc);
+  has_error_ = true;
+  error_message_ = error;
+  error_loc_ = loc;
   token_.setKind(clang::tok::eof);
 }
 
+void Parser::ClearError() {
+  has_error_ = false;
+  error_message_.clear();
+  error_.clear();
+}
+
 // Parse an expression.
 //
 //  expression:
@@ -233,8 +236,7 @@ ExprResult Parser::ParseConditionalExpression() {
     Expect(clang::tok::colon);
     ConsumeToken();
     auto false_val = ParseAssignmentExpression();
-    lhs = std::make_unique<TernaryOpNode>(std::move(lhs), std::move(true_val),
-                                          std::move(false_val));
+    lhs = MakeNode<TernaryOpNode>(lhs, true_val, false_val);
   }
 
   return lhs;
@@ -252,7 +254,7 @@ ExprResult Parser::ParseLogicalOrExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseLogicalAndExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -270,7 +272,7 @@ ExprResult Parser::ParseLogicalAndExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseInclusiveOrExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -288,7 +290,7 @@ ExprResult Parser::ParseInclusiveOrExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseExclusiveOrExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -306,7 +308,7 @@ ExprResult Parser::ParseExclusiveOrExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseAndExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -324,7 +326,7 @@ ExprResult Parser::ParseAndExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseEqualityExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -343,7 +345,7 @@ ExprResult Parser::ParseEqualityExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseRelationalExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -365,7 +367,7 @@ ExprResult Parser::ParseRelationalExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseShiftExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -384,7 +386,7 @@ ExprResult Parser::ParseShiftExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseAdditiveExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -403,7 +405,7 @@ ExprResult Parser::ParseAdditiveExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseMultiplicativeExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -424,7 +426,7 @@ ExprResult Parser::ParseMultiplicativeExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseCastExpression();
-    lhs = std::make_unique<BinaryOpNode>(kind, std::move(lhs), std::move(rhs));
+    lhs = MakeNode<BinaryOpNode>(kind, lhs, rhs);
   }
 
   return lhs;
@@ -459,7 +461,7 @@ ExprResult Parser::ParseCastExpression() {
       ConsumeToken();
       auto rhs = ParseCastExpression();
 
-      return std::make_unique<CStyleCastNode>(type_decl, std::move(rhs));
+      return MakeNode<CStyleCastNode>(type_decl, rhs);
 
     } else {
       // Failed to parse the contents of the parentheses as a type declaration.
@@ -495,7 +497,7 @@ ExprResult Parser::ParseUnaryExpression() {
     clang::tok::TokenKind kind = token_.getKind();
     ConsumeToken();
     auto rhs = ParseCastExpression();
-    return std::make_unique<UnaryOpNode>(kind, std::move(rhs));
+    return MakeNode<UnaryOpNode>(kind, rhs);
   }
 
   return ParsePostfixExpression();
@@ -524,8 +526,7 @@ ExprResult Parser::ParsePostfixExpression() {
                         : MemberOfNode::Type::OF_POINTER;
         ConsumeToken();
         auto member_id = ParseIdExpression();
-        lhs = std::make_unique<MemberOfNode>(type, std::move(lhs),
-                                             std::move(member_id));
+        lhs = MakeNode<MemberOfNode>(type, lhs, member_id);
         break;
       }
       case clang::tok::plusplus:
@@ -533,21 +534,20 @@ ExprResult Parser::ParsePostfixExpression() {
         BailOut(
             "Don't support postfix inc/dec yet: " + TokenDescription(token_),
             token_.getLocation());
-        return std::make_unique<ErrorNode>();
+        return MakeNode<ErrorNode>();
       }
       case clang::tok::l_square: {
         ConsumeToken();
         auto rhs = ParseExpression();
         Expect(clang::tok::r_square);
         ConsumeToken();
-        lhs = std::make_unique<BinaryOpNode>(clang::tok::l_square,
-                                             std::move(lhs), std::move(rhs));
+        lhs = MakeNode<BinaryOpNode>(clang::tok::l_square, lhs, rhs);
         break;
       }
       default: {
         BailOut("Can't parse this: " + TokenDescription(token_),
                 token_.getLocation());
-        return std::make_unique<ErrorNode>();
+        return MakeNode<ErrorNode>();
       }
     }
   }
@@ -573,7 +573,7 @@ ExprResult Parser::ParsePrimaryExpression() {
     return ParseIdExpression();
   } else if (token_.is(clang::tok::kw_this)) {
     ConsumeToken();
-    return std::make_unique<IdentifierNode>("this");
+    return MakeNode<IdentifierNode>("this");
   } else if (token_.is(clang::tok::l_paren)) {
     ConsumeToken();
     auto expr = ParseExpression();
@@ -584,7 +584,7 @@ ExprResult Parser::ParsePrimaryExpression() {
 
   BailOut("Unexpected token: " + TokenDescription(token_),
           token_.getLocation());
-  return std::make_unique<ErrorNode>();
+  return MakeNode<ErrorNode>();
 }
 
 // Parse a type_id.
@@ -658,7 +658,7 @@ bool Parser::ParseTypeSpecifier(TypeDeclaration* type_decl) {
   }
 
   if (IsSimpleTypeSpecifierKeyword(token_)) {
-    type_decl->typenames_.push_back(pp_->getSpelling(token_));
+    type_decl->typenames_.push_back(GetTokenText(token_));
     ConsumeToken();
     return true;
   }
@@ -684,13 +684,15 @@ bool Parser::ParseTypeSpecifier(TypeDeclaration* type_decl) {
     // optional. In this case type_name is type we're looking for.
     if (!type_name.empty()) {
       // Construct the fully qualified typename.
-      auto type_specifier = llvm::formatv("{0}{1}{2}", global_scope ? "::" : "",
-                                          nested_name_specifier, type_name);
+      std::string type_specifier =
+          llvm::formatv("{0}{1}{2}", global_scope ? "::" : "",
+                        nested_name_specifier, type_name);
 
       // This is a user-defined type now. Typedefs from standard library (e.g.
       // "uint64_t") are also considered user-defined.
       type_decl->is_builtin_ = false;
-      type_decl->typenames_.push_back(type_specifier);
+      type_decl->typenames_.push_back(
+          expr_ctx_->GetAstArena().CopyString(type_specifier));
       return true;
     }
   }
@@ -715,9 +717,9 @@ std::string Parser::ParseNestedNameSpecifier() {
 
   // If the next token is scope ("::"), then this is indeed a
   // nested_name_specifier
-  if (pp_->LookAhead(0).is(clang::tok::coloncolon)) {
+  if (LookAhead(0).is(clang::tok::coloncolon)) {
     // This nested_name_specifier is a single identifier.
-    std::string identifier = pp_->getSpelling(token_);
+    std::string identifier = env_->GetSpelling(token_);
     ConsumeToken();
     Expect(clang::tok::coloncolon);
     ConsumeToken();
@@ -727,7 +729,7 @@ std::string Parser::ParseNestedNameSpecifier() {
 
   // If the next token starts a template argument list, then we have a
   // simple_template_id here.
-  if (pp_->LookAhead(0).is(clang::tok::less)) {
+  if (LookAhead(0).is(clang::tok::less)) {
     // We don't know whether this will be a nested_name_identifier or just a
     // type_name. Prepare to rollback if this is not a nested_name_identifier.
     TentativeParsingAction tentative_parsing(this);
@@ -778,9 +780,9 @@ std::string Parser::ParseTypeName() {
 
   // If the next token starts a template argument list, parse this type_name as
   // a simple_template_id.
-  if (pp_->LookAhead(0).is(clang::tok::less)) {
+  if (LookAhead(0).is(clang::tok::less)) {
     // Parse the template_name. In this case it's just an identifier.
-    std::string template_name = pp_->getSpelling(token_);
+    std::string template_name = env_->GetSpelling(token_);
     ConsumeToken();
     // Consume the "<" token.
     ConsumeToken();
@@ -805,7 +807,7 @@ std::string Parser::ParseTypeName() {
   }
 
   // Otherwise look for a class_name, enum_name or a typedef_name.
-  std::string identifier = pp_->getSpelling(token_);
+  std::string identifier = env_->GetSpelling(token_);
   ConsumeToken();
 
   return identifier;
@@ -898,7 +900,7 @@ std::string Parser::ParseTemplateArgument() {
     // finish the template_argument, then we're done here.
     if (!HasError() && token_.isOneOf(clang::tok::comma, clang::tok::greater)) {
       tentative_parsing.Commit();
-      return id_expression->name();
+      return id_expression->name().str();
     }
     // Failed to parse a id_expression.
     tentative_parsing.Rollback();
@@ -1010,25 +1012,28 @@ IdExpression Parser::ParseIdExpression() {
     // Parse unqualified_id and construct a fully qualified id expression.
     auto unqualified_id = ParseUnqualifiedId();
 
-    auto id_expression = llvm::formatv("{0}{1}{2}", global_scope ? "::" : "",
-                                       nested_name_specifier, unqualified_id);
-    return std::make_unique<IdentifierNode>(id_expression);
+    std::string id_expression =
+        llvm::formatv("{0}{1}{2}", global_scope ? "::" : "",
+                      nested_name_specifier, unqualified_id);
+    return MakeNode<IdentifierNode>(
+        expr_ctx_->GetAstArena().CopyString(id_expression));
   }
 
   // No nested_name_specifier, but with global scope -- this is also a
   // qualified_id production. Follow the second production rule.
   else if (global_scope) {
     Expect(clang::tok::identifier);
-    std::string identifier = pp_->getSpelling(token_);
+    llvm::StringRef identifier = GetTokenText(token_);
     ConsumeToken();
-    auto id_expression =
+    std::string id_expression =
         llvm::formatv("{0}{1}", global_scope ? "::" : "", identifier);
-    return std::make_unique<IdentifierNode>(id_expression);
+    return MakeNode<IdentifierNode>(
+        expr_ctx_->GetAstArena().CopyString(id_expression));
   }
 
   // This is unqualified_id production.
   auto unqualified_id = ParseUnqualifiedId();
-  return std::make_unique<IdentifierNode>(unqualified_id);
+  return MakeNode<IdentifierNode>(unqualified_id);
 }
 
 // Parse an unqualified_id.
@@ -1039,9 +1044,9 @@ IdExpression Parser::ParseIdExpression() {
 //  identifier:
 //    ? clang::tok::identifier ?
 //
-std::string Parser::ParseUnqualifiedId() {
+llvm::StringRef Parser::ParseUnqualifiedId() {
   Expect(clang::tok::identifier);
-  std::string identifier = pp_->getSpelling(token_);
+  llvm::StringRef identifier = GetTokenText(token_);
   ConsumeToken();
   return identifier;
 }
@@ -1068,26 +1073,27 @@ ExprResult Parser::ParseBooleanLiteral() {
   ExpectOneOf(clang::tok::kw_true, clang::tok::kw_false);
   bool literal_value = token_.is(clang::tok::kw_true);
   ConsumeToken();
-  return std::make_unique<BooleanLiteralNode>(literal_value);
+  return MakeNode<BooleanLiteralNode>(literal_value);
 }
 
 ExprResult Parser::ParseNumericConstant(clang::Token token) {
   // Parse numeric constant, it can be either integer or float.
-  std::string tok_spelling = pp_->getSpelling(token);
+  std::string tok_spelling = env_->GetSpelling(token);
 
 #if LLVM_VERSION_MAJOR >= 11
   clang::NumericLiteralParser literal(
-      tok_spelling, token.getLocation(), pp_->getSourceManager(),
-      pp_->getLangOpts(), pp_->getTargetInfo(), pp_->getDiagnostics());
+      tok_spelling, token.getLocation(), env_->GetSourceManager(),
+      env_->GetLangOpts(), env_->GetTargetInfo(), env_->GetDiagnostics());
 #else
-  clang::NumericLiteralParser literal(tok_spelling, token.getLocation(), *pp_);
+  clang::NumericLiteralParser literal(tok_spelling, token.getLocation(),
+                                      env_->GetPreprocessor());
 #endif
 
   if (literal.hadError) {
     BailOut(
         "Failed to parse token as numeric-constant: " + TokenDescription(token),
         token.getLocation());
-    return std::make_unique<ErrorNode>();
+    return MakeNode<ErrorNode>();
   }
 
   // Check for floating-literal and integer-literal. Fail on anything else (i.e.
@@ -1103,7 +1109,7 @@ ExprResult Parser::ParseNumericConstant(clang::Token token) {
   BailOut("numeric-constant should be either float or integer literal: " +
               TokenDescription(token),
           token.getLocation());
-  return std::make_unique<ErrorNode>();
+  return MakeNode<ErrorNode>();
 }
 
 ExprResult Parser::ParseFloatingLiteral(clang::NumericLiteralParser& literal,
@@ -1120,13 +1126,13 @@ ExprResult Parser::ParseFloatingLiteral(clang::NumericLiteralParser& literal,
       ((result & llvm::APFloat::opUnderflow) && raw_value.isZero())) {
     BailOut("float underflow/overflow happened: " + TokenDescription(token),
             token.getLocation());
-    return std::make_unique<ErrorNode>();
+    return MakeNode<ErrorNode>();
   }
 
   Scalar value = literal.isFloat ? Scalar(raw_value.convertToFloat())
                                  : Scalar(raw_value.convertToDouble());
 
-  return std::make_unique<NumericLiteralNode>(value);
+  return MakeNode<NumericLiteralNode>(value);
 }
 
 ExprResult Parser::ParseIntegerLiteral(clang::NumericLiteralParser& literal,
@@ -1140,7 +1146,7 @@ ExprResult Parser::ParseIntegerLiteral(clang::NumericLiteralParser& literal,
         "type: " +
             TokenDescription(token),
         token.getLocation());
-    return std::make_unique<ErrorNode>();
+    return MakeNode<ErrorNode>();
   }
 
   Scalar value;
@@ -1168,10 +1174,10 @@ ExprResult Parser::ParseIntegerLiteral(clang::NumericLiteralParser& literal,
     BailOut("unexpected int width (" + std::to_string(int_type.width) +
                 ") for numeric constant: " + TokenDescription(token),
             token.getLocation());
-    return std::make_unique<ErrorNode>();
+    return MakeNode<ErrorNode>();
   }
 
-  return std::make_unique<NumericLiteralNode>(value);
+  return MakeNode<NumericLiteralNode>(value);
 }
 
 }  // namespace lldb_eval
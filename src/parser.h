@@ -17,19 +17,20 @@
 #ifndef LLDB_EVAL_PARSER_H_
 #define LLDB_EVAL_PARSER_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "ast.h"
-#include "clang/Basic/FileManager.h"
-#include "clang/Basic/LangOptions.h"
 #include "clang/Basic/SourceLocation.h"
-#include "clang/Basic/TargetInfo.h"
-#include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/LiteralSupport.h"
-#include "clang/Lex/ModuleLoader.h"
-#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Token.h"
 #include "expression_context.h"
+#include "lexer.h"
+#include "llvm/ADT/StringRef.h"
 
 namespace lldb_eval {
 
@@ -55,12 +56,20 @@ class Parser {
   using Error = std::string;
 
  public:
-  explicit Parser(ExpressionContext& expr_ctx);
+  explicit Parser(ExpressionContext& expr_ctx,
+                  LexerKind lexer_kind = LexerKind::CLANG);
+  ~Parser();
+
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
 
   ExprResult Run();
 
-  bool HasError() { return !error_.empty(); }
-  const Error& GetError() { return error_; }
+  bool HasError() { return has_error_; }
+  // The error message points to the error location in the expression. It's
+  // formatted on the first request, since the errors of the tentative parsing
+  // are usually discarded.
+  const Error& GetError();
 
  private:
   ExprResult ParseExpression();
@@ -99,7 +108,7 @@ class Parser {
   bool IsPtrOperator(clang::Token token) const;
 
   IdExpression ParseIdExpression();
-  std::string ParseUnqualifiedId();
+  llvm::StringRef ParseUnqualifiedId();
 
   ExprResult ParseNumericLiteral();
   ExprResult ParseBooleanLiteral();
@@ -111,7 +120,23 @@ class Parser {
                                  clang::Token token);
 
   void ConsumeToken();
+
+  // Returns the text of the token. The result refers to the expression text or
+  // the AST arena and lives as long as the expression context.
+  llvm::StringRef GetTokenText(const clang::Token& token);
+
+  template <typename T, typename... Args>
+  T* MakeNode(Args&&... args) {
+    return expr_ctx_->GetAstArena().Create<T>(std::forward<Args>(args)...);
+  }
+
+  // Returns the token `n + 1` positions after the current one.
+  const clang::Token& LookAhead(size_t n) const {
+    return tokens_[std::min(next_token_ + n, tokens_.size() - 1)];
+  }
+
   void BailOut(const std::string& error, clang::SourceLocation loc);
+  void ClearError();
 
   void Expect(clang::tok::TokenKind kind) {
     if (token_.isNot(kind)) {
@@ -131,7 +156,7 @@ class Parser {
   }
 
   std::string TokenDescription(const clang::Token& token) {
-    auto spelling = pp_->getSpelling(token);
+    auto spelling = env_->GetSpelling(token);
     auto kind_name = token.getName();
     return "<'" + spelling + "' (" + kind_name + ")>";
   }
@@ -139,21 +164,26 @@ class Parser {
  private:
   friend class TentativeParsingAction;
 
-  // Parser doesn't own expression context. The produced AST may depend on it
-  // (for example, for source locations), so it's expected that expression
-  // context will outlive the parser.
+  // Parser doesn't own expression context. The produced AST is allocated in
+  // its arena and refers to the expression text, so it's expected that
+  // expression context will outlive the parser.
   ExpressionContext* expr_ctx_;
 
   // The token lexer is stopped at (aka "current token").
   clang::Token token_;
-  // Holds an error if it occures during parsing.
+  // Holds an error if it occures during parsing. The message is formatted
+  // together with the location on demand.
+  bool has_error_;
+  std::string error_message_;
+  clang::SourceLocation error_loc_;
   Error error_;
 
-  std::unique_ptr<clang::TargetInfo> ti_;
-  std::unique_ptr<clang::LangOptions> lang_opts_;
-  std::unique_ptr<clang::HeaderSearch> hs_;
-  std::unique_ptr<clang::TrivialModuleLoader> tml_;
-  std::unique_ptr<clang::Preprocessor> pp_;
+  // Lexer state shared with other parsers on the current thread.
+  LexerEnvironment* env_;
+  // All tokens of the expression, the last one is always eof.
+  std::vector<clang::Token> tokens_;
+  // Index of the token following the current one.
+  size_t next_token_;
 };
 
 // Enables tentative parsing mode, allowing to rollback the parser state. Call
@@ -163,7 +193,7 @@ class TentativeParsingAction {
  public:
   TentativeParsingAction(Parser* parser) : parser_(parser) {
     backtrack_token_ = parser_->token_;
-    parser_->pp_->EnableBacktrackAtThisPos();
+    backtrack_next_token_ = parser_->next_token_;
     enabled_ = true;
   }
 
@@ -173,20 +203,18 @@ class TentativeParsingAction {
            "Commit() or Rollback()?");
   }
 
-  void Commit() {
-    parser_->pp_->CommitBacktrackedTokens();
-    enabled_ = false;
-  }
+  void Commit() { enabled_ = false; }
   void Rollback() {
-    parser_->pp_->Backtrack();
-    parser_->error_.clear();
+    parser_->ClearError();
     parser_->token_ = backtrack_token_;
+    parser_->next_token_ = backtrack_next_token_;
     enabled_ = false;
   }
 
  private:
   Parser* parser_;
   clang::Token backtrack_token_;
+  size_t backtrack_next_token_;
   bool enabled_;
 };
 
@@ -0,0 +1,133 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "clang/Lex/Token.h"
+#include "expression_context.h"
+#include "lexer.h"
+#include "lldb/API/SBExecutionContext.h"
+#include "parser.h"
+
+// Count the heap allocations to measure how many of them the parser performs.
+// Memory for the AST is allocated in slabs by the arena, which doesn't go
+// through operator new, so slabs are reported separately.
+static std::atomic<size_t> g_num_allocations(0);
+
+void* operator new(size_t size) {
+  ++g_num_allocations;
+  void* ptr = std::malloc(size);
+  if (!ptr) {
+    std::abort();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+using lldb_eval::LexerEnvironment;
+using lldb_eval::LexerKind;
+
+// Typical expressions, which don't require the target to be parsed.
+const char* kExpressions[] = {
+    "a",
+    "1 + 2 * (4 - 5) + 6 / 3 - (7 % 8)",
+    "foo->bar.baz[idx_1] + c_arr[1].field_",
+    "p_ptr != p_nullptr && (*p_int0 << 2) >= 0x10 || trueVar",
+    "1.5e+10 * ll_max / 3u - (int_min % 7) ^ ~uint_max",
+};
+
+// Benchmark argument for selecting the lexer.
+LexerKind GetLexerKind(const benchmark::State& state) {
+  return state.range(0) == 0 ? LexerKind::CLANG : LexerKind::BUILTIN;
+}
+
+void BM_Lex(benchmark::State& state) {
+  LexerEnvironment& env = LexerEnvironment::GetForCurrentThread();
+  LexerKind kind = GetLexerKind(state);
+  state.SetLabel(kind == LexerKind::CLANG ? "clang" : "builtin");
+
+  std::vector<std::string> exprs(std::begin(kExpressions),
+                                 std::end(kExpressions));
+  std::vector<clang::Token> tokens;
+  size_t num_tokens = 0;
+
+  for (auto _ : state) {
+    for (const auto& expr : exprs) {
+      tokens.clear();
+      env.Lex(expr, &tokens, kind);
+      env.ReleaseSource();
+      num_tokens += tokens.size();
+    }
+  }
+
+  state.counters["tokens/s"] = benchmark::Counter(
+      static_cast<double>(num_tokens), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Lex)->Arg(0)->Arg(1);
+
+void BM_Parse(benchmark::State& state) {
+  LexerKind kind = GetLexerKind(state);
+  state.SetLabel(kind == LexerKind::CLANG ? "clang" : "builtin");
+
+  for (auto _ : state) {
+    for (const char* expr : kExpressions) {
+      lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext());
+      lldb_eval::Parser parser(expr_ctx, kind);
+      auto tree = parser.Run();
+      benchmark::DoNotOptimize(tree);
+    }
+  }
+}
+BENCHMARK(BM_Parse)->Arg(0)->Arg(1);
+
+// Number of heap allocations performed by Parser::Run() (including lexing,
+// which happens in the constructor) for a typical member access expression.
+void BM_ParseAllocations(benchmark::State& state) {
+  LexerKind kind = GetLexerKind(state);
+  state.SetLabel(kind == LexerKind::CLANG ? "clang" : "builtin");
+
+  const char* expr = "a->b[i].c";
+  size_t num_allocations = 0;
+  size_t num_slabs = 0;
+
+  for (auto _ : state) {
+    lldb_eval::ExpressionContext expr_ctx(expr, lldb::SBExecutionContext());
+
+    size_t before = g_num_allocations;
+    {
+      lldb_eval::Parser parser(expr_ctx, kind);
+      auto tree = parser.Run();
+      benchmark::DoNotOptimize(tree);
+    }
+    num_allocations += g_num_allocations - before;
+    num_slabs += expr_ctx.GetAstArena().GetNumSlabs();
+  }
+
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(num_allocations), benchmark::Counter::kAvgIterations);
+  state.counters["arena_slabs"] = benchmark::Counter(
+      static_cast<double>(num_slabs), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ParseAllocations)->Arg(0)->Arg(1);
+
+}  // namespace
@@ -16,26 +16,33 @@
 
 #include "lldb/API/SBValue.h"
 #include "lldb/lldb-enumerations.h"
+#include "lldb/API/SBError.h"
+#include "memory_cache.h"
 #include "scalar.h"
+#include "type_info.h"
 
 namespace lldb_eval {
 
 bool Pointer::AsBool() const { return addr_ != 0; }
 
 bool Pointer::IsPointerToVoid() {
-  return type_.GetPointeeType().GetBasicType() == lldb::eBasicTypeVoid;
+  return GetTypeInfo(type_).pointee_basic_type == lldb::eBasicTypeVoid;
 }
 
 Pointer Pointer::Add(int64_t offset) {
-  return Pointer(addr_ + offset * type_.GetPointeeType().GetByteSize(), type_);
+  return Pointer(addr_ + offset * GetTypeInfo(type_).pointee_size, type_);
 }
 
 Pointer Pointer::FromSbValue(lldb::SBValue value) {
-  if (!value.GetType().GetCanonicalType().IsPointerType()) {
+  if (!GetTypeInfo(value.GetType()).is_pointer) {
     return Pointer();
   }
 
-  uint64_t base_addr = value.GetValueAsUnsigned();
+  lldb::SBError error;
+  uint64_t base_addr = ReadValueData(value).GetAddress(error, 0);
+  if (error.Fail()) {
+    base_addr = 0;
+  }
   lldb::SBType item_type = value.GetType();
 
   return Pointer(base_addr, item_type);
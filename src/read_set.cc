@@ -0,0 +1,132 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "read_set.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lldb/API/SBData.h"
+#include "lldb/API/SBError.h"
+#include "lldb/API/SBType.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-defines.h"
+#include "memory_cache.h"
+
+namespace {
+
+thread_local lldb_eval::ReadSet* current_read_set = nullptr;
+
+std::vector<uint8_t> GetBytes(lldb::SBData data) {
+  std::vector<uint8_t> bytes(data.GetByteSize());
+  lldb::SBError error;
+  size_t size = data.ReadRawData(error, 0, bytes.data(), bytes.size());
+  bytes.resize(error.Fail() ? 0 : size);
+  return bytes;
+}
+
+}  // namespace
+
+namespace lldb_eval {
+
+void ReadSet::AddVariable(llvm::StringRef name, lldb::SBValue value) {
+  Variable var;
+  var.name = name.str();
+  var.found = value.IsValid();
+  var.addr = var.found ? value.GetLoadAddress() : LLDB_INVALID_ADDRESS;
+  if (var.found) {
+    var.type = value.GetType();
+    if (var.addr == LLDB_INVALID_ADDRESS) {
+      var.data = GetBytes(value.GetData());
+    }
+  }
+  variables_.push_back(std::move(var));
+}
+
+void ReadSet::AddMemory(lldb::addr_t addr, const void* bytes, size_t size) {
+  const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+  memory_.push_back({addr, std::vector<uint8_t>(begin, begin + size)});
+}
+
+bool ReadSet::IsUnchanged(LookupFn lookup, MemoryCache& cache) const {
+  for (const Variable& var : variables_) {
+    lldb::SBValue value = lookup(var.name);
+    if (value.IsValid() != var.found) {
+      return false;
+    }
+    if (!var.found) {
+      continue;
+    }
+
+    // SB API objects are references, copying them is cheap.
+    lldb::SBType type = value.GetType();
+    lldb::SBType recorded_type = var.type;
+    if (value.GetLoadAddress() != var.addr || type != recorded_type) {
+      return false;
+    }
+    if (var.addr == LLDB_INVALID_ADDRESS &&
+        GetBytes(value.GetData()) != var.data) {
+      return false;
+    }
+  }
+
+  std::vector<uint8_t> buf;
+  for (const MemoryRange& range : memory_) {
+    buf.resize(range.data.size());
+    if (!cache.Read(range.addr, buf.data(), buf.size()) || buf != range.data) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void ReadSet::Clear() {
+  variables_.clear();
+  memory_.clear();
+}
+
+ReadSetScope::ReadSetScope(ReadSet* read_set) : previous_(current_read_set) {
+  current_read_set = read_set;
+}
+
+ReadSetScope::~ReadSetScope() { current_read_set = previous_; }
+
+ReadSet* GetCurrentReadSet() { return current_read_set; }
+
+void TrackVariable(llvm::StringRef name, lldb::SBValue value) {
+  if (current_read_set) {
+    current_read_set->AddVariable(name, value);
+  }
+}
+
+void TrackRead(lldb::SBValue value) {
+  if (!current_read_set) {
+    return;
+  }
+  lldb::addr_t addr = value.GetLoadAddress();
+  if (addr != LLDB_INVALID_ADDRESS) {
+    std::vector<uint8_t> bytes = GetBytes(value.GetData());
+    current_read_set->AddMemory(addr, bytes.data(), bytes.size());
+  }
+}
+
+void TrackRead(lldb::addr_t addr, const void* bytes, size_t size) {
+  if (current_read_set) {
+    current_read_set->AddMemory(addr, bytes, size);
+  }
+}
+
+}  // namespace lldb_eval
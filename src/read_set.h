@@ -0,0 +1,104 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_READ_SET_H_
+#define LLDB_EVAL_READ_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lldb/API/SBData.h"
+#include "lldb/API/SBType.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-types.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "memory_cache.h"
+
+namespace lldb_eval {
+
+// Inputs of an evaluation: the variables the identifiers resolved to and the
+// bytes of the target memory the interpreter has read. If none of them has
+// changed, evaluating the same expression again gives the same result. The
+// types are assumed not to change, i.e. the modules of the target are the same.
+class ReadSet {
+ public:
+  // Resolves the identifier the same way as the interpreter does.
+  using LookupFn = llvm::function_ref<lldb::SBValue(llvm::StringRef)>;
+
+  // Records the variable `name` resolved to. Invalid `value` means the
+  // variable wasn't found. The data of values not located in memory (e.g. in
+  // registers) is recorded too.
+  void AddVariable(llvm::StringRef name, lldb::SBValue value);
+
+  // Records `size` bytes of the target memory at `addr`.
+  void AddMemory(lldb::addr_t addr, const void* bytes, size_t size);
+
+  // Returns true if the variables resolve to the same locations and the
+  // recorded memory has the same contents. The memory is read through `cache`.
+  bool IsUnchanged(LookupFn lookup, MemoryCache& cache) const;
+
+  void Clear();
+
+ private:
+  struct Variable {
+    std::string name;
+    bool found;
+    lldb::addr_t addr;
+    lldb::SBType type;
+    // Data of the values which are not located in memory.
+    std::vector<uint8_t> data;
+  };
+
+  struct MemoryRange {
+    lldb::addr_t addr;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<Variable> variables_;
+  std::vector<MemoryRange> memory_;
+};
+
+// Records the inputs of the evaluation running on the current thread to
+// `read_set` until the end of the scope.
+class ReadSetScope {
+ public:
+  explicit ReadSetScope(ReadSet* read_set);
+  ~ReadSetScope();
+
+  ReadSetScope(const ReadSetScope&) = delete;
+  ReadSetScope& operator=(const ReadSetScope&) = delete;
+
+ private:
+  ReadSet* previous_;
+};
+
+// Returns the read set of the current evaluation, or nullptr if the inputs are
+// not recorded.
+ReadSet* GetCurrentReadSet();
+
+// Add the inputs to the current read set, if there is one. Values which are not
+// located in memory (e.g. the results of the arithmetic) are not recorded by
+// `TrackRead()`, they are derived from other inputs.
+void TrackVariable(llvm::StringRef name, lldb::SBValue value);
+void TrackRead(lldb::SBValue value);
+void TrackRead(lldb::addr_t addr, const void* bytes, size_t size);
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_READ_SET_H_
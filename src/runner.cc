@@ -14,9 +14,11 @@
 
 #include "runner.h"
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "lldb/API/SBBreakpoint.h"
 #include "lldb/API/SBBreakpointLocation.h"
@@ -24,6 +26,7 @@
 #include "lldb/API/SBCommandReturnObject.h"
 #include "lldb/API/SBDebugger.h"
 #include "lldb/API/SBDefines.h"
+#include "lldb/API/SBError.h"
 #include "lldb/API/SBEvent.h"
 #include "lldb/API/SBFileSpec.h"
 #include "lldb/API/SBFrame.h"
@@ -40,6 +43,9 @@ namespace lldb_eval {
 
 using bazel::tools::cpp::runfiles::Runfiles;
 
+// Location of the test program in the runfiles.
+const char* kTestBinary = "lldb_eval/testdata/test_binary";
+
 // Running a process can be slow when built with sanitizers.
 const uint32_t kWaitForEventTimeout = 5;
 
@@ -68,16 +74,8 @@ int FindBreakpointLine(const Runfiles& runfiles,
   exit(1);
 }
 
-lldb::SBProcess LaunchTestProgram(const Runfiles& runfiles,
-                                  lldb::SBDebugger debugger,
-                                  const std::string& break_line) {
-  std::string binary = runfiles.Rlocation("lldb_eval/testdata/test_binary");
-  lldb::SBTarget target = debugger.CreateTarget(binary.c_str());
-
-  lldb::SBBreakpoint bp = target.BreakpointCreateByLocation(
-      "test_binary.cc", FindBreakpointLine(runfiles, break_line));
-  lldb::SBProcess process = target.LaunchSimple(nullptr, nullptr, ".");
-
+bool WaitForBreakpoint(lldb::SBDebugger debugger, lldb::SBProcess process,
+                       lldb::SBBreakpoint bp) {
   bool running = true;
   lldb::SBEvent event;
   lldb::SBListener listener = debugger.GetListener();
@@ -112,6 +110,8 @@ lldb::SBProcess LaunchTestProgram(const Runfiles& runfiles,
           }
           break;
         }
+        case lldb::eStateExited:
+          return false;
         default:
           break;
       }
@@ -125,6 +125,162 @@ lldb::SBProcess LaunchTestProgram(const Runfiles& runfiles,
     }
   }
 
+  return true;
+}
+
+lldb::SBProcess LaunchTestProgram(const Runfiles& runfiles,
+                                  lldb::SBDebugger debugger,
+                                  const std::string& break_line) {
+  std::string binary = runfiles.Rlocation(kTestBinary);
+  lldb::SBTarget target = debugger.CreateTarget(binary.c_str());
+
+  lldb::SBBreakpoint bp = target.BreakpointCreateByLocation(
+      "test_binary.cc", FindBreakpointLine(runfiles, break_line));
+  lldb::SBProcess process = target.LaunchSimple(nullptr, nullptr, ".");
+
+  WaitForBreakpoint(debugger, process, bp);
+  target.BreakpointDelete(bp.GetID());
+
+  return process;
+}
+
+bool ContinueToBreakpoint(const Runfiles& runfiles, lldb::SBProcess process,
+                          const std::string& break_line) {
+  lldb::SBTarget target = process.GetTarget();
+
+  lldb::SBBreakpoint bp = target.BreakpointCreateByLocation(
+      "test_binary.cc", FindBreakpointLine(runfiles, break_line));
+
+  // Several marked lines can share the location, e.g. the comments before the
+  // same statement.
+  bool stopped = false;
+  lldb::addr_t pc = process.GetSelectedThread().GetSelectedFrame().GetPC();
+  for (size_t i = 0; i < bp.GetNumLocations(); ++i) {
+    if (bp.GetLocationAtIndex(static_cast<uint32_t>(i)).GetLoadAddress() ==
+        pc) {
+      stopped = true;
+    }
+  }
+
+  if (!stopped) {
+    process.Continue();
+    stopped = WaitForBreakpoint(target.GetDebugger(), process, bp);
+  }
+
+  target.BreakpointDelete(bp.GetID());
+  return stopped;
+}
+
+namespace {
+
+// Hash of the contents of the file, empty if it can't be read.
+std::string FingerprintFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return "";
+  }
+  // 64-bit FNV-1a.
+  uint64_t hash = 14695981039346656037ull;
+  char buffer[4096];
+  while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+    for (std::streamsize i = 0; i < file.gcount(); ++i) {
+      hash ^= static_cast<unsigned char>(buffer[i]);
+      hash *= 1099511628211ull;
+    }
+  }
+  return std::to_string(hash);
+}
+
+// Returns true if the core has the memory of the global variables, i.e. it
+// isn't a minidump with only the stacks.
+bool CoreHasGlobals(const std::string& binary, lldb::SBDebugger debugger,
+                    const std::string& core_path) {
+  lldb::SBTarget target = debugger.CreateTarget(binary.c_str());
+  lldb::SBError error;
+  target.LoadCore(core_path.c_str(), error);
+  lldb::SBValue global = target.FindFirstGlobalVariable("globalVar");
+  int64_t value = global.GetValueAsSigned(error);
+  bool ok = error.Success() && value == static_cast<int32_t>(0xDEADBEEF);
+  debugger.DeleteTarget(target);
+  return ok;
+}
+
+}  // namespace
+
+bool SaveTestProgramCores(const Runfiles& runfiles, lldb::SBDebugger debugger,
+                          const std::vector<std::string>& sites,
+                          const std::string& core_dir,
+                          std::vector<std::string>* paths, std::string* error) {
+  paths->clear();
+  lldb::SBProcess process;
+
+  // The cores are reused only if they were saved from the same build of the
+  // test program, otherwise they don't match its debug info.
+  std::string binary = runfiles.Rlocation(kTestBinary);
+  std::string fingerprint = FingerprintFile(binary);
+  std::string fingerprint_path = core_dir + "/test_binary.fingerprint";
+  std::string saved_fingerprint;
+  std::ifstream(fingerprint_path) >> saved_fingerprint;
+  bool reuse_cores = !fingerprint.empty() && fingerprint == saved_fingerprint;
+  bool checked_core = false;
+
+  for (const std::string& site : sites) {
+    std::string path = core_dir + "/" + site + ".core";
+    paths->push_back(path);
+    if (reuse_cores && std::ifstream(path).good()) {
+      continue;
+    }
+
+    std::string break_line = "// BREAK(" + site + ")";
+    if (!process.IsValid() ||
+        !ContinueToBreakpoint(runfiles, process, break_line)) {
+      process.Destroy();
+      process = LaunchTestProgram(runfiles, debugger, break_line);
+    }
+
+    lldb::SBError save_error = process.SaveCore(path.c_str());
+    if (save_error.Fail()) {
+      *error = "This LLDB can't save core dumps of the test program (" +
+               std::string(save_error.GetCString()) + ")";
+      process.Destroy();
+      return false;
+    }
+
+    // Check the first core saved by this LLDB, the others are of the same
+    // kind.
+    if (!checked_core && !CoreHasGlobals(binary, debugger, path)) {
+      *error =
+          "The core dumps saved by this LLDB don't contain the memory of the "
+          "global variables (e.g. minidumps with only the stacks)";
+      process.Destroy();
+      return false;
+    }
+    checked_core = true;
+  }
+
+  if (process.IsValid()) {
+    process.Destroy();
+  }
+  std::ofstream(fingerprint_path) << fingerprint << std::endl;
+  return true;
+}
+
+lldb::SBProcess LoadTestProgramCore(const Runfiles& runfiles,
+                                    lldb::SBDebugger debugger,
+                                    const std::string& core_path) {
+  std::string binary = runfiles.Rlocation(kTestBinary);
+  lldb::SBTarget target = debugger.CreateTarget(binary.c_str());
+
+  lldb::SBError error;
+  lldb::SBProcess process = target.LoadCore(core_path.c_str(), error);
+  if (!process.IsValid()) {
+    std::cerr << "Can't load the core dump " << core_path;
+    if (error.Fail()) {
+      std::cerr << ": " << error.GetCString();
+    }
+    std::cerr << std::endl;
+    exit(1);
+  }
   return process;
 }
 
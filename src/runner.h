@@ -18,7 +18,9 @@
 #define LLDB_EVAL_RUNNER_H_
 
 #include <string>
+#include <vector>
 
+#include "lldb/API/SBBreakpoint.h"
 #include "lldb/API/SBDebugger.h"
 #include "lldb/API/SBProcess.h"
 #include "tools/cpp/runfiles/runfiles.h"
@@ -26,10 +28,56 @@
 namespace lldb_eval {
 
 void SetupLLDBServerEnv(const bazel::tools::cpp::runfiles::Runfiles& runfiles);
+
+// Returns the number of the line marked with `break_line` in the source of the
+// test program.
+int FindBreakpointLine(const bazel::tools::cpp::runfiles::Runfiles& runfiles,
+                       const std::string& break_line);
+
+// Waits until the process stops at the given breakpoint. Returns false if the
+// process exits instead.
+bool WaitForBreakpoint(lldb::SBDebugger debugger, lldb::SBProcess process,
+                       lldb::SBBreakpoint bp);
+
 lldb::SBProcess LaunchTestProgram(
     const bazel::tools::cpp::runfiles::Runfiles& runfiles,
     lldb::SBDebugger debugger, const std::string& break_line);
 
+// Resumes the process launched by `LaunchTestProgram()` and waits until it
+// stops at the line marked with `break_line`. The process isn't resumed if it
+// is already stopped there. Returns false if the process exits instead, i.e.
+// the line isn't executed after the current stop location.
+bool ContinueToBreakpoint(const bazel::tools::cpp::runfiles::Runfiles& runfiles,
+                          lldb::SBProcess process,
+                          const std::string& break_line);
+
+// Makes sure `core_dir` has a core dump of the test program stopped at each of
+// the given BREAK sites, e.g. "TestArithmetic" for the line marked with
+// "// BREAK(TestArithmetic)". The missing cores are saved from a single run of
+// the program, which is launched again only if a site has already been passed.
+// A fingerprint of the test program is stored next to the cores, all of them
+// are saved again when the program is rebuilt. Stores the paths of the cores in
+// the order of `sites` to `paths`.
+//
+// The cores are saved with `SBProcess::SaveCore()` and must contain the whole
+// memory of the process, not only the stacks. Returns false and describes the
+// reason in `error` if the LLDB in use can't save such cores (e.g. LLDB 10 can't
+// save them on Linux at all).
+bool SaveTestProgramCores(const bazel::tools::cpp::runfiles::Runfiles& runfiles,
+                          lldb::SBDebugger debugger,
+                          const std::vector<std::string>& sites,
+                          const std::string& core_dir,
+                          std::vector<std::string>* paths, std::string* error);
+
+// Loads a core dump of the test program saved by `SaveTestProgramCores()`.
+// The process is stopped at the site the core was saved at and can be
+// inspected the same way as a live one, but it can't be resumed. The memory
+// never changes and no debug server is needed, which makes the measurements
+// repeatable.
+lldb::SBProcess LoadTestProgramCore(
+    const bazel::tools::cpp::runfiles::Runfiles& runfiles,
+    lldb::SBDebugger debugger, const std::string& core_path);
+
 }  // namespace lldb_eval
 
 #endif  // LLDB_EVAL_RUNNER_H_
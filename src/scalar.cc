@@ -14,173 +14,25 @@
 
 #include "scalar.h"
 
+#include <array>
+#include <cstddef>
 #include <string>
+#include <utility>
 
 #include "defines.h"
 #include "lldb/API/SBError.h"
 #include "lldb/API/SBType.h"
 #include "lldb/API/SBValue.h"
 #include "lldb/lldb-enumerations.h"
+#include "memory_cache.h"
+#include "type_info.h"
 
 namespace lldb_eval {
 
-Scalar::Type PromoteOperands(const Scalar& lhs, const Scalar& rhs, Scalar* a,
-                             Scalar* b) {
-  *a = lhs;
-  *b = rhs;
-
-  if (a->type_ > b->type_) {
-    b->PromoteTo(a->type_);
-  } else if (a->type_ < b->type_) {
-    a->PromoteTo(b->type_);
-  }
-
-  if (a->type_ == b->type_) {
-    return a->type_;
-  }
-  return Scalar::Type::INVALID;
-}
-
-void Scalar::PromoteTo(Type type) {
-  switch (type_) {
-    case Type::INVALID:
-      // Can't promote undefined values.
-      SetInvalid();
-      break;
-
-    case Type::INT32:
-      switch (type) {
-        case Type::INVALID:
-          SetInvalid();
-          break;
-        case Type::INT32:
-          // No-op, already required type.
-          break;
-        case Type::UINT32:
-          SetValueUInt32(value_.int32_);
-          break;
-        case Type::INT64:
-          SetValueInt64(value_.int32_);
-          break;
-        case Type::UINT64:
-          SetValueUInt64(value_.int32_);
-          break;
-        case Type::FLOAT:
-          SetValueFloat(static_cast<float>(value_.int32_));
-          break;
-        case Type::DOUBLE:
-          SetValueDouble(static_cast<double>(value_.int32_));
-          break;
-      }
-      break;
-
-    case Type::UINT32:
-      switch (type) {
-        case Type::INVALID:
-        case Type::INT32:
-          SetInvalid();
-          break;
-        case Type::UINT32:
-          // No-op, already required type.
-          break;
-        case Type::INT64:
-          SetValueInt64(value_.uint32_);
-          break;
-        case Type::UINT64:
-          SetValueUInt64(value_.uint32_);
-          break;
-        case Type::FLOAT:
-          SetValueFloat(static_cast<float>(value_.uint32_));
-          break;
-        case Type::DOUBLE:
-          SetValueDouble(static_cast<double>(value_.uint32_));
-          break;
-      }
-      break;
-
-    case Type::INT64:
-      switch (type) {
-        case Type::INVALID:
-        case Type::INT32:
-        case Type::UINT32:
-          SetInvalid();
-          break;
-        case Type::INT64:
-          // No-op, already required type.
-          break;
-        case Type::UINT64:
-          SetValueUInt64(value_.int64_);
-          break;
-        case Type::FLOAT:
-          SetValueFloat(static_cast<float>(value_.int64_));
-          break;
-        case Type::DOUBLE:
-          SetValueDouble(static_cast<double>(value_.int64_));
-          break;
-      }
-      break;
-
-    case Type::UINT64:
-      switch (type) {
-        case Type::INVALID:
-        case Type::INT32:
-        case Type::UINT32:
-        case Type::INT64:
-          SetInvalid();
-          break;
-        case Type::UINT64:
-          // No-op, already required type.
-          break;
-        case Type::FLOAT:
-          SetValueFloat(static_cast<float>(value_.uint64_));
-          break;
-        case Type::DOUBLE:
-          SetValueDouble(static_cast<double>(value_.uint64_));
-          break;
-      }
-      break;
-
-    case Type::FLOAT:
-      switch (type) {
-        case Type::INVALID:
-        case Type::INT32:
-        case Type::UINT32:
-        case Type::INT64:
-        case Type::UINT64:
-          SetInvalid();
-          break;
-        case Type::FLOAT:
-          // No-op, already required type.
-          break;
-        case Type::DOUBLE:
-          SetValueDouble(static_cast<double>(value_.float_));
-          break;
-      }
-      break;
-
-    case Type::DOUBLE:
-      switch (type) {
-        case Type::INVALID:
-        case Type::INT32:
-        case Type::UINT32:
-        case Type::INT64:
-        case Type::UINT64:
-        case Type::FLOAT:
-          SetInvalid();
-          break;
-        case Type::DOUBLE:
-          // No-op, already required type.
-          break;
-      }
-      break;
-  }
-}
-
 Scalar Scalar::FromSbValue(lldb::SBValue value) {
-  // Get the canonical type, because the initial one can be a typedef/alias.
-  lldb::SBType type = value.GetType().GetCanonicalType();
-
-  switch (type.GetBasicType()) {
+  // The basic type of the canonical type, because the initial one can be a
+  // typedef/alias.
+  switch (GetTypeInfo(value.GetType()).basic_type) {
     case lldb::eBasicTypeInvalid: {
       // Can't get a Scalar out of SBValue with non-basic type.
       break;
@@ -206,7 +58,7 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
     }
     case lldb::eBasicTypeBool: {
       lldb::SBError error;
-      uint8_t val = value.GetData().GetUnsignedInt8(error, 0);
+      uint8_t val = ReadValueData(value).GetUnsignedInt8(error, 0);
       if (error) {
         // Error trying to get uint8_t: error.GetCString()
         break;
@@ -228,16 +80,16 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
 
       switch (value.GetByteSize()) {
         case 1:
-          ret = Scalar(value.GetData().GetSignedInt8(error, 0));
+          ret = Scalar(ReadValueData(value).GetSignedInt8(error, 0));
           break;
         case 2:
-          ret = Scalar(value.GetData().GetSignedInt16(error, 0));
+          ret = Scalar(ReadValueData(value).GetSignedInt16(error, 0));
           break;
         case 4:
-          ret = Scalar(value.GetData().GetSignedInt32(error, 0));
+          ret = Scalar(ReadValueData(value).GetSignedInt32(error, 0));
           break;
         case 8:
-          ret = Scalar(value.GetData().GetSignedInt64(error, 0));
+          ret = Scalar(ReadValueData(value).GetSignedInt64(error, 0));
           break;
         default:
           // Unexpected byte size, maybe it's int128?
@@ -262,16 +114,16 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
 
       switch (value.GetByteSize()) {
         case 1:
-          ret = Scalar(value.GetData().GetUnsignedInt8(error, 0));
+          ret = Scalar(ReadValueData(value).GetUnsignedInt8(error, 0));
           break;
         case 2:
-          ret = Scalar(value.GetData().GetUnsignedInt16(error, 0));
+          ret = Scalar(ReadValueData(value).GetUnsignedInt16(error, 0));
           break;
         case 4:
-          ret = Scalar(value.GetData().GetUnsignedInt32(error, 0));
+          ret = Scalar(ReadValueData(value).GetUnsignedInt32(error, 0));
           break;
         case 8:
-          ret = Scalar(value.GetData().GetUnsignedInt64(error, 0));
+          ret = Scalar(ReadValueData(value).GetUnsignedInt64(error, 0));
           break;
         default:
           // Unexpected byte size, maybe it's int128?
@@ -287,7 +139,7 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
     }
     case lldb::eBasicTypeFloat: {
       lldb::SBError error;
-      float val = value.GetData().GetFloat(error, 0);
+      float val = ReadValueData(value).GetFloat(error, 0);
       if (error) {
         // Error trying to get float: error.GetCString()
         break;
@@ -296,7 +148,7 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
     }
     case lldb::eBasicTypeDouble: {
       lldb::SBError error;
-      double val = value.GetData().GetDouble(error, 0);
+      double val = ReadValueData(value).GetDouble(error, 0);
       if (error) {
         // Error trying to get double: error.GetCString()
         break;
@@ -309,330 +161,224 @@ Scalar Scalar::FromSbValue(lldb::SBValue value) {
   return Scalar();
 }
 
-const Scalar operator+(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+namespace {
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ + b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ + b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ + b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ + b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-      ret.SetValueFloat(a.value_.float_ + b.value_.float_);
-      break;
-    case Scalar::Type::DOUBLE:
-      ret.SetValueDouble(a.value_.double_ + b.value_.double_);
-      break;
-  }
+constexpr size_t kNumTypes = static_cast<size_t>(Scalar::Type::DOUBLE) + 1;
 
-  return ret;
+// Type of the operands of a binary operator after the usual arithmetic
+// conversions, i.e. the operand with the lower rank is promoted to the type of
+// the other one. Operations involving invalid scalars are invalid.
+constexpr Scalar::Type CommonType(Scalar::Type lhs, Scalar::Type rhs) {
+  return lhs == Scalar::Type::INVALID || rhs == Scalar::Type::INVALID
+             ? Scalar::Type::INVALID
+             : (lhs > rhs ? lhs : rhs);
 }
 
-const Scalar operator-(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+constexpr bool IsIntegral(Scalar::Type type) {
+  return type != Scalar::Type::INVALID && type != Scalar::Type::FLOAT &&
+         type != Scalar::Type::DOUBLE;
+}
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ - b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ - b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ - b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ - b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-      ret.SetValueFloat(a.value_.float_ - b.value_.float_);
-      break;
-    case Scalar::Type::DOUBLE:
-      ret.SetValueDouble(a.value_.double_ - b.value_.double_);
-      break;
+// C++ type storing the scalar of the given type.
+template <Scalar::Type type>
+struct ScalarTraits;
+
+template <>
+struct ScalarTraits<Scalar::Type::INT32> {
+  using CType = int32_t;
+  static CType Get(const Scalar& s) { return s.value_.int32_; }
+};
+
+template <>
+struct ScalarTraits<Scalar::Type::UINT32> {
+  using CType = uint32_t;
+  static CType Get(const Scalar& s) { return s.value_.uint32_; }
+};
+
+template <>
+struct ScalarTraits<Scalar::Type::INT64> {
+  using CType = int64_t;
+  static CType Get(const Scalar& s) { return s.value_.int64_; }
+};
+
+template <>
+struct ScalarTraits<Scalar::Type::UINT64> {
+  using CType = uint64_t;
+  static CType Get(const Scalar& s) { return s.value_.uint64_; }
+};
+
+template <>
+struct ScalarTraits<Scalar::Type::FLOAT> {
+  using CType = float;
+  static CType Get(const Scalar& s) { return s.value_.float_; }
+};
+
+template <>
+struct ScalarTraits<Scalar::Type::DOUBLE> {
+  using CType = double;
+  static CType Get(const Scalar& s) { return s.value_.double_; }
+};
+
+// Operators. `Result` is the return type of the operator, its default value is
+// returned for the invalid operands. Operators with `kIntegralOnly` are
+// invalid for floating point operands.
+struct ArithmeticOp {
+  using Result = Scalar;
+  static constexpr bool kIntegralOnly = false;
+};
+
+struct IntegralOp {
+  using Result = Scalar;
+  static constexpr bool kIntegralOnly = true;
+};
+
+struct ComparisonOp {
+  using Result = bool;
+  static constexpr bool kIntegralOnly = false;
+};
+
+#define LLDB_EVAL_SCALAR_OP(name, kind, op)   \
+  struct name : kind {                        \
+    template <typename T>                     \
+    static Result Apply(T lhs, T rhs) {       \
+      return static_cast<Result>(lhs op rhs); \
+    }                                         \
   }
 
-  return ret;
-}
-
-const Scalar operator/(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+// The result of the arithmetic operators is converted back to the type of the
+// operands, since the integers narrower than `int` aren't represented.
+#define LLDB_EVAL_SCALAR_ARITHMETIC_OP(name, kind, op) \
+  struct name : kind {                                 \
+    template <typename T>                              \
+    static Result Apply(T lhs, T rhs) {                \
+      return Scalar(static_cast<T>(lhs op rhs));       \
+    }                                                  \
+  }
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ / b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ / b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ / b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ / b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-      ret.SetValueFloat(a.value_.float_ / b.value_.float_);
-      break;
-    case Scalar::Type::DOUBLE:
-      ret.SetValueDouble(a.value_.double_ / b.value_.double_);
-      break;
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(AddOp, ArithmeticOp, +);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(SubOp, ArithmeticOp, -);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(MulOp, ArithmeticOp, *);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(DivOp, ArithmeticOp, /);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(RemOp, IntegralOp, %);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(AndOp, IntegralOp, &);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(OrOp, IntegralOp, |);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(XorOp, IntegralOp, ^);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(ShlOp, IntegralOp, <<);
+LLDB_EVAL_SCALAR_ARITHMETIC_OP(ShrOp, IntegralOp, >>);
+LLDB_EVAL_SCALAR_OP(EqOp, ComparisonOp, ==);
+LLDB_EVAL_SCALAR_OP(LtOp, ComparisonOp, <);
+
+#undef LLDB_EVAL_SCALAR_ARITHMETIC_OP
+#undef LLDB_EVAL_SCALAR_OP
+
+template <typename Op, Scalar::Type type,
+          bool valid = IsIntegral(type) ||
+                       (type != Scalar::Type::INVALID && !Op::kIntegralOnly)>
+struct Invoke {
+  template <Scalar::Type lhs_type, Scalar::Type rhs_type>
+  static typename Op::Result Call(const Scalar& lhs, const Scalar& rhs) {
+    using T = typename ScalarTraits<type>::CType;
+    return Op::Apply(static_cast<T>(ScalarTraits<lhs_type>::Get(lhs)),
+                     static_cast<T>(ScalarTraits<rhs_type>::Get(rhs)));
   }
+};
 
-  return ret;
+template <typename Op, Scalar::Type type>
+struct Invoke<Op, type, false> {
+  template <Scalar::Type lhs_type, Scalar::Type rhs_type>
+  static typename Op::Result Call(const Scalar&, const Scalar&) {
+    return typename Op::Result();
+  }
+};
+
+// Applies the operator to the scalars of the given types. The promotion and
+// the operation for every combination of the types is resolved at compile
+// time.
+template <typename Op, Scalar::Type lhs_type, Scalar::Type rhs_type>
+typename Op::Result Dispatch(const Scalar& lhs, const Scalar& rhs) {
+  using Invoker = Invoke<Op, CommonType(lhs_type, rhs_type)>;
+  return Invoker::template Call<lhs_type, rhs_type>(lhs, rhs);
 }
 
-const Scalar operator*(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ * b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ * b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ * b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ * b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-      ret.SetValueFloat(a.value_.float_ * b.value_.float_);
-      break;
-    case Scalar::Type::DOUBLE:
-      ret.SetValueDouble(a.value_.double_ * b.value_.double_);
-      break;
-  }
+template <typename Op>
+using DispatchFn = typename Op::Result (*)(const Scalar&, const Scalar&);
 
-  return ret;
+template <typename Op, size_t... I>
+constexpr std::array<DispatchFn<Op>, sizeof...(I)> MakeDispatchTable(
+    std::index_sequence<I...>) {
+  return {{&Dispatch<Op, static_cast<Scalar::Type>(I / kNumTypes),
+                     static_cast<Scalar::Type>(I % kNumTypes)>...}};
 }
 
-const Scalar operator&(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+// Table of `Dispatch()` instances indexed by (lhs type, rhs type).
+template <typename Op>
+struct DispatchTable {
+  static constexpr std::array<DispatchFn<Op>, kNumTypes * kNumTypes> kFns =
+      MakeDispatchTable<Op>(std::make_index_sequence<kNumTypes * kNumTypes>());
+};
+
+template <typename Op>
+constexpr std::array<DispatchFn<Op>, kNumTypes * kNumTypes>
+    DispatchTable<Op>::kFns;
+
+template <typename Op>
+typename Op::Result Apply(const Scalar& lhs, const Scalar& rhs) {
+  size_t index = static_cast<size_t>(lhs.type_) * kNumTypes +
+                 static_cast<size_t>(rhs.type_);
+  return DispatchTable<Op>::kFns[index](lhs, rhs);
+}
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ & b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ & b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ & b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ & b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do & on float/double.
-      break;
-  }
+}  // namespace
 
-  return ret;
+const Scalar operator+(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<AddOp>(lhs, rhs);
 }
 
-const Scalar operator|(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+const Scalar operator-(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<SubOp>(lhs, rhs);
+}
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ | b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ | b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ | b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ | b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do | on float/double.
-      break;
-  }
+const Scalar operator/(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<DivOp>(lhs, rhs);
+}
 
-  return ret;
+const Scalar operator*(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<MulOp>(lhs, rhs);
 }
 
-const Scalar operator%(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
+const Scalar operator&(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<AndOp>(lhs, rhs);
+}
 
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ % b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ % b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ % b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ % b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do % on float/double.
-      break;
-  }
+const Scalar operator|(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<OrOp>(lhs, rhs);
+}
 
-  return ret;
+const Scalar operator%(const Scalar& lhs, const Scalar& rhs) {
+  return Apply<RemOp>(lhs, rhs);
 }
 
 const Scalar operator^(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ ^ b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ ^ b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ ^ b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ ^ b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do ^ on float/double.
-      break;
-  }
-
-  return ret;
+  return Apply<XorOp>(lhs, rhs);
 }
 
 const Scalar operator<<(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ << b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ << b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ << b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ << b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do << on float/double.
-      break;
-  }
-
-  return ret;
+  return Apply<ShlOp>(lhs, rhs);
 }
 
 const Scalar operator>>(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b, ret;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      break;
-    case Scalar::Type::INT32:
-      ret.SetValueInt32(a.value_.int32_ >> b.value_.int32_);
-      break;
-    case Scalar::Type::UINT32:
-      ret.SetValueUInt32(a.value_.uint32_ >> b.value_.uint32_);
-      break;
-    case Scalar::Type::INT64:
-      ret.SetValueInt64(a.value_.int64_ >> b.value_.int64_);
-      break;
-    case Scalar::Type::UINT64:
-      ret.SetValueUInt64(a.value_.uint64_ >> b.value_.uint64_);
-      break;
-    case Scalar::Type::FLOAT:
-    case Scalar::Type::DOUBLE:
-      // Can't do >> on float/double.
-      break;
-  }
-
-  return ret;
+  return Apply<ShrOp>(lhs, rhs);
 }
 
 bool operator==(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      // TODO(werat): Handle error somehow.
-      return false;
-    case Scalar::Type::INT32:
-      return a.value_.int32_ == b.value_.int32_;
-    case Scalar::Type::UINT32:
-      return a.value_.uint32_ == b.value_.uint32_;
-    case Scalar::Type::INT64:
-      return a.value_.int64_ == b.value_.int64_;
-    case Scalar::Type::UINT64:
-      return a.value_.uint64_ == b.value_.uint64_;
-    case Scalar::Type::FLOAT:
-      return a.value_.float_ == b.value_.float_;
-    case Scalar::Type::DOUBLE:
-      return a.value_.double_ == b.value_.double_;
-  }
-  unreachable("Scalar::Type enum wasn't exhausted in the switch statement.");
+  // TODO(werat): Handle invalid operands somehow, false is returned for now.
+  return Apply<EqOp>(lhs, rhs);
 }
 
 bool operator!=(const Scalar& lhs, const Scalar& rhs) { return !(lhs == rhs); }
 
 bool operator<(const Scalar& lhs, const Scalar& rhs) {
-  Scalar a, b;
-
-  switch (PromoteOperands(lhs, rhs, &a, &b)) {
-    case Scalar::Type::INVALID:
-      // TODO(werat): Handle error somehow.
-      return false;
-    case Scalar::Type::INT32:
-      return a.value_.int32_ < b.value_.int32_;
-    case Scalar::Type::UINT32:
-      return a.value_.uint32_ < b.value_.uint32_;
-    case Scalar::Type::INT64:
-      return a.value_.int64_ < b.value_.int64_;
-    case Scalar::Type::UINT64:
-      return a.value_.uint64_ < b.value_.uint64_;
-    case Scalar::Type::FLOAT:
-      return a.value_.float_ < b.value_.float_;
-    case Scalar::Type::DOUBLE:
-      return a.value_.double_ < b.value_.double_;
-  }
-  unreachable("Scalar::Type enum wasn't exhausted in the switch statement.");
+  return Apply<LtOp>(lhs, rhs);
 }
 
 bool operator<=(const Scalar& lhs, const Scalar& rhs) { return !(rhs < lhs); }
@@ -17,6 +17,7 @@
 #ifndef LLDB_EVAL_SCALAR_H_
 #define LLDB_EVAL_SCALAR_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -87,28 +88,10 @@ class Scalar {
     value_.double_ = value;
   }
 
-  void PromoteTo(Type type);
-
+  // The value converted to `T` according to the C++ rules. The conversion is
+  // looked up in a table indexed by the type of the scalar.
   template <typename T>
-  T GetAs() const {
-    switch (type_) {
-      case Type::INVALID:
-        return T();
-      case Type::INT32:
-        return static_cast<T>(value_.int32_);
-      case Type::UINT32:
-        return static_cast<T>(value_.uint32_);
-      case Type::INT64:
-        return static_cast<T>(value_.int64_);
-      case Type::UINT64:
-        return static_cast<T>(value_.uint64_);
-      case Type::FLOAT:
-        return static_cast<T>(value_.float_);
-      case Type::DOUBLE:
-        return static_cast<T>(value_.double_);
-    }
-    unreachable("Scalar::Type enum wasn't exhausted in the switch statement.");
-  }
+  T GetAs() const;
 
   bool AsBool() const { return GetAs<bool>(); }
 
@@ -156,5 +139,45 @@ bool operator<=(const Scalar& lhs, const Scalar& rhs);
 bool operator>(const Scalar& lhs, const Scalar& rhs);
 bool operator>=(const Scalar& lhs, const Scalar& rhs);
 
+namespace internal {
+
+template <typename T, typename U, U Scalar::Data::*member>
+T LoadScalarAs(const Scalar::Data& data) {
+  return static_cast<T>(data.*member);
+}
+
+template <typename T>
+T LoadInvalidScalarAs(const Scalar::Data&) {
+  return T();
+}
+
+// Conversions of the stored value to `T`, in the order of `Scalar::Type`.
+template <typename T>
+struct ScalarGetAs {
+  using Fn = T (*)(const Scalar::Data&);
+  static constexpr Fn kTable[] = {
+      &LoadInvalidScalarAs<T>,
+      &LoadScalarAs<T, int32_t, &Scalar::Data::int32_>,
+      &LoadScalarAs<T, uint32_t, &Scalar::Data::uint32_>,
+      &LoadScalarAs<T, int64_t, &Scalar::Data::int64_>,
+      &LoadScalarAs<T, uint64_t, &Scalar::Data::uint64_>,
+      &LoadScalarAs<T, float, &Scalar::Data::float_>,
+      &LoadScalarAs<T, double, &Scalar::Data::double_>,
+  };
+  static_assert(sizeof(kTable) / sizeof(kTable[0]) ==
+                    static_cast<size_t>(Scalar::Type::DOUBLE) + 1,
+                "The table must have an entry for every Scalar::Type.");
+};
+
+template <typename T>
+constexpr typename ScalarGetAs<T>::Fn ScalarGetAs<T>::kTable[];
+
+}  // namespace internal
+
+template <typename T>
+T Scalar::GetAs() const {
+  return internal::ScalarGetAs<T>::kTable[static_cast<size_t>(type_)](value_);
+}
+
 }  // namespace lldb_eval
 #endif  // LLDB_EVAL_SCALAR_H_
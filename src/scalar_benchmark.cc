@@ -0,0 +1,96 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "scalar.h"
+
+namespace {
+
+using lldb_eval::Scalar;
+
+// A scalar of every valid type. The values are small and non-zero, so all
+// operators (including the division and the shifts) are well defined.
+std::vector<Scalar> MakeOperands() {
+  return {
+      Scalar(static_cast<int32_t>(3)),  Scalar(static_cast<uint32_t>(3)),
+      Scalar(static_cast<int64_t>(3)),  Scalar(static_cast<uint64_t>(3)),
+      Scalar(static_cast<float>(3.0)),  Scalar(static_cast<double>(3.0)),
+  };
+}
+
+// Applies the operator to every pair of the operand types. This includes the
+// pairs the operator isn't defined for (e.g. `%` on floating point numbers),
+// which produce an invalid result.
+template <typename Op>
+void BM_ScalarOp(benchmark::State& state, Op op) {
+  std::vector<Scalar> operands = MakeOperands();
+
+  for (auto _ : state) {
+    for (const Scalar& lhs : operands) {
+      for (const Scalar& rhs : operands) {
+        benchmark::DoNotOptimize(op(lhs, rhs));
+      }
+    }
+  }
+
+  state.counters["ops/s"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * operands.size() *
+                          operands.size()),
+      benchmark::Counter::kIsRate);
+}
+
+#define SCALAR_OP_BENCHMARK(name, op)                          \
+  BENCHMARK_CAPTURE(BM_ScalarOp, name,                         \
+                    [](const Scalar& lhs, const Scalar& rhs) { \
+                      return lhs op rhs;                       \
+                    })
+
+SCALAR_OP_BENCHMARK(add, +);
+SCALAR_OP_BENCHMARK(sub, -);
+SCALAR_OP_BENCHMARK(mul, *);
+SCALAR_OP_BENCHMARK(div, /);
+SCALAR_OP_BENCHMARK(rem, %);
+SCALAR_OP_BENCHMARK(and, &);
+SCALAR_OP_BENCHMARK(or, |);
+SCALAR_OP_BENCHMARK(xor, ^);
+SCALAR_OP_BENCHMARK(shl, <<);
+SCALAR_OP_BENCHMARK(shr, >>);
+SCALAR_OP_BENCHMARK(eq, ==);
+SCALAR_OP_BENCHMARK(ne, !=);
+SCALAR_OP_BENCHMARK(lt, <);
+SCALAR_OP_BENCHMARK(le, <=);
+SCALAR_OP_BENCHMARK(gt, >);
+SCALAR_OP_BENCHMARK(ge, >=);
+
+#undef SCALAR_OP_BENCHMARK
+
+// Conversions of every operand type to the types used by the interpreter.
+void BM_ScalarGetAs(benchmark::State& state) {
+  std::vector<Scalar> operands = MakeOperands();
+
+  for (auto _ : state) {
+    for (const Scalar& s : operands) {
+      benchmark::DoNotOptimize(s.AsBool());
+      benchmark::DoNotOptimize(s.GetAs<int64_t>());
+      benchmark::DoNotOptimize(s.GetAs<uint64_t>());
+      benchmark::DoNotOptimize(s.GetAs<double>());
+    }
+  }
+}
+BENCHMARK(BM_ScalarGetAs);
+
+}  // namespace
@@ -0,0 +1,192 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "scalar.h"
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using lldb_eval::Scalar;
+
+template <typename T>
+struct ScalarTypeOf;
+
+template <>
+struct ScalarTypeOf<int32_t> {
+  static constexpr Scalar::Type kType = Scalar::Type::INT32;
+};
+
+template <>
+struct ScalarTypeOf<uint32_t> {
+  static constexpr Scalar::Type kType = Scalar::Type::UINT32;
+};
+
+template <>
+struct ScalarTypeOf<int64_t> {
+  static constexpr Scalar::Type kType = Scalar::Type::INT64;
+};
+
+template <>
+struct ScalarTypeOf<uint64_t> {
+  static constexpr Scalar::Type kType = Scalar::Type::UINT64;
+};
+
+template <>
+struct ScalarTypeOf<float> {
+  static constexpr Scalar::Type kType = Scalar::Type::FLOAT;
+};
+
+template <>
+struct ScalarTypeOf<double> {
+  static constexpr Scalar::Type kType = Scalar::Type::DOUBLE;
+};
+
+template <typename T>
+void ExpectScalar(const Scalar& actual, T expected, const std::string& op) {
+  SCOPED_TRACE(op);
+  Scalar::Type expected_type = ScalarTypeOf<T>::kType;
+  EXPECT_EQ(actual.type_, expected_type);
+  EXPECT_EQ(actual.GetAs<T>(), expected);
+}
+
+void ExpectInvalid(const Scalar& actual, const std::string& op) {
+  SCOPED_TRACE(op);
+  EXPECT_EQ(actual.type_, Scalar::Type::INVALID);
+}
+
+// Operators defined only for the integral operands. `C` is the type of the
+// operands after the usual arithmetic conversions.
+template <typename C>
+void CheckIntegralOps(const Scalar& lhs, const Scalar& rhs, C l, C r,
+                      std::true_type) {
+  ExpectScalar<C>(lhs % rhs, l % r, "%");
+  ExpectScalar<C>(lhs & rhs, l & r, "&");
+  ExpectScalar<C>(lhs | rhs, l | r, "|");
+  ExpectScalar<C>(lhs ^ rhs, l ^ r, "^");
+
+  // The shifts are undefined for the negative operands and the shift amounts
+  // exceeding the width of the type. Unlike C++, the operands of the shifts
+  // go through the usual arithmetic conversions too.
+  if (l >= 0 && r >= 0 && r < 32) {
+    ExpectScalar<C>(lhs << rhs, l << r, "<<");
+    ExpectScalar<C>(lhs >> rhs, l >> r, ">>");
+  }
+}
+
+template <typename C>
+void CheckIntegralOps(const Scalar& lhs, const Scalar& rhs, C, C,
+                      std::false_type) {
+  ExpectInvalid(lhs % rhs, "%");
+  ExpectInvalid(lhs & rhs, "&");
+  ExpectInvalid(lhs | rhs, "|");
+  ExpectInvalid(lhs ^ rhs, "^");
+  ExpectInvalid(lhs << rhs, "<<");
+  ExpectInvalid(lhs >> rhs, ">>");
+}
+
+// Compares the result of every operator with the result of the same operator
+// applied to the C++ values.
+template <typename L, typename R>
+void CheckOps(L lhs_value, R rhs_value) {
+  // The type of the operands after the usual arithmetic conversions.
+  using C = decltype(lhs_value + rhs_value);
+  C l = static_cast<C>(lhs_value);
+  C r = static_cast<C>(rhs_value);
+
+  SCOPED_TRACE(std::to_string(lhs_value) + " (" +
+               std::to_string(static_cast<int>(ScalarTypeOf<L>::kType)) +
+               "), " + std::to_string(rhs_value) + " (" +
+               std::to_string(static_cast<int>(ScalarTypeOf<R>::kType)) +
+               ")");
+  Scalar lhs(lhs_value);
+  Scalar rhs(rhs_value);
+
+  ExpectScalar<C>(lhs + rhs, l + r, "+");
+  ExpectScalar<C>(lhs - rhs, l - r, "-");
+  ExpectScalar<C>(lhs * rhs, l * r, "*");
+  ExpectScalar<C>(lhs / rhs, l / r, "/");
+  CheckIntegralOps<C>(lhs, rhs, l, r, std::is_integral<C>());
+
+  EXPECT_EQ(lhs == rhs, l == r);
+  EXPECT_EQ(lhs != rhs, l != r);
+  EXPECT_EQ(lhs < rhs, l < r);
+  EXPECT_EQ(lhs <= rhs, l <= r);
+  EXPECT_EQ(lhs > rhs, l > r);
+  EXPECT_EQ(lhs >= rhs, l >= r);
+}
+
+template <typename L, typename R>
+void CheckValues() {
+  // Negative values check the conversions between the signed and the unsigned
+  // types. Zero isn't used on the right to avoid the division by zero.
+  const int kLhs[] = {7, -7, 0};
+  const int kRhs[] = {2, -3, 7};
+  for (int lhs : kLhs) {
+    for (int rhs : kRhs) {
+      CheckOps(static_cast<L>(lhs), static_cast<R>(rhs));
+    }
+  }
+}
+
+template <typename L>
+void CheckAllRhsTypes() {
+  CheckValues<L, int32_t>();
+  CheckValues<L, uint32_t>();
+  CheckValues<L, int64_t>();
+  CheckValues<L, uint64_t>();
+  CheckValues<L, float>();
+  CheckValues<L, double>();
+}
+
+TEST(ScalarTest, TestUsualArithmeticConversions) {
+  CheckAllRhsTypes<int32_t>();
+  CheckAllRhsTypes<uint32_t>();
+  CheckAllRhsTypes<int64_t>();
+  CheckAllRhsTypes<uint64_t>();
+  CheckAllRhsTypes<float>();
+  CheckAllRhsTypes<double>();
+}
+
+TEST(ScalarTest, TestInvalidOperands) {
+  Scalar valid(1);
+  Scalar invalid;
+
+  for (const Scalar& lhs : {valid, invalid}) {
+    for (const Scalar& rhs : {valid, invalid}) {
+      if (lhs.type_ != Scalar::Type::INVALID &&
+          rhs.type_ != Scalar::Type::INVALID) {
+        continue;
+      }
+      ExpectInvalid(lhs + rhs, "+");
+      ExpectInvalid(lhs - rhs, "-");
+      ExpectInvalid(lhs * rhs, "*");
+      ExpectInvalid(lhs / rhs, "/");
+      ExpectInvalid(lhs % rhs, "%");
+      ExpectInvalid(lhs & rhs, "&");
+      ExpectInvalid(lhs | rhs, "|");
+      ExpectInvalid(lhs ^ rhs, "^");
+      ExpectInvalid(lhs << rhs, "<<");
+      ExpectInvalid(lhs >> rhs, ">>");
+      EXPECT_FALSE(lhs == rhs);
+      EXPECT_FALSE(lhs < rhs);
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,49 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stats.h"
+
+#include "api.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-defines.h"
+
+namespace {
+
+thread_local lldb_eval::EvalStats* current_stats = nullptr;
+
+}  // namespace
+
+namespace lldb_eval {
+
+StatsScope::StatsScope(EvalStats* stats) : previous_(current_stats) {
+  current_stats = stats;
+}
+
+StatsScope::~StatsScope() { current_stats = previous_; }
+
+EvalStats* GetCurrentStats() { return current_stats; }
+
+void RecordValueRead(lldb::SBValue value) {
+  if (!current_stats) {
+    return;
+  }
+  // Results of the previous operations are stored on the host and don't have
+  // a load address.
+  if (value.GetLoadAddress() == LLDB_INVALID_ADDRESS) {
+    return;
+  }
+  current_stats->bytes_read += value.GetByteSize();
+}
+
+}  // namespace lldb_eval
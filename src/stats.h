@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_STATS_H_
+#define LLDB_EVAL_STATS_H_
+
+#include "api.h"
+#include "lldb/API/SBValue.h"
+
+namespace lldb_eval {
+
+// Directs the statistics of the evaluation running on the current thread to
+// `stats` until the end of the scope. The statistics are collected deep in the
+// parser and the interpreter (e.g. when creating values), so they are not
+// passed around explicitly. `stats` can be nullptr, then nothing is collected.
+class StatsScope {
+ public:
+  explicit StatsScope(EvalStats* stats);
+  ~StatsScope();
+
+  StatsScope(const StatsScope&) = delete;
+  StatsScope& operator=(const StatsScope&) = delete;
+
+ private:
+  EvalStats* previous_;
+};
+
+// Returns the statistics of the current evaluation, or nullptr if they are not
+// collected.
+EvalStats* GetCurrentStats();
+
+// Counts the bytes of `value` as read from the target. Values created by the
+// interpreter itself don't come from the target and are not counted.
+void RecordValueRead(lldb::SBValue value);
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_STATS_H_
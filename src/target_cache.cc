@@ -0,0 +1,216 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "target_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lldb/API/SBAddress.h"
+#include "lldb/API/SBEvent.h"
+#include "lldb/API/SBListener.h"
+#include "lldb/API/SBTarget.h"
+#include "lldb/API/SBType.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-defines.h"
+#include "lldb/lldb-types.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace {
+
+// Target events, which make the cached results stale.
+const uint32_t kModuleEvents = lldb::SBTarget::eBroadcastBitModulesLoaded |
+                               lldb::SBTarget::eBroadcastBitModulesUnloaded |
+                               lldb::SBTarget::eBroadcastBitSymbolsLoaded;
+
+// Caches of all targets. There are usually very few targets, so a linear
+// search is fine.
+struct Registry {
+  using Entry =
+      std::pair<lldb::SBTarget, std::shared_ptr<lldb_eval::TargetCache>>;
+
+  std::mutex mutex;
+  std::vector<Entry> caches;
+};
+
+Registry& GetRegistry() {
+  // Never destroyed, since the targets may not outlive the debugger.
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+// Key of the member `name` of the record type `record`.
+std::string MemberKey(lldb::SBType record, llvm::StringRef name) {
+  const char* record_name = record.GetName();
+  std::string key = record_name ? record_name : "";
+  key += "::";
+  key += name;
+  return key;
+}
+
+}  // namespace
+
+namespace lldb_eval {
+
+std::shared_ptr<TargetCache> TargetCache::Get(lldb::SBTarget target) {
+  if (!target.IsValid()) {
+    return nullptr;
+  }
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  // Drop the caches of the deleted targets.
+  auto& caches = registry.caches;
+  caches.erase(std::remove_if(caches.begin(), caches.end(),
+                              [](const auto& entry) {
+                                return !entry.first.IsValid();
+                              }),
+               caches.end());
+
+  for (const auto& entry : caches) {
+    if (entry.first == target) {
+      return entry.second;
+    }
+  }
+
+  auto cache = std::make_shared<TargetCache>(target);
+  caches.emplace_back(target, cache);
+  return cache;
+}
+
+TargetCache::TargetCache(lldb::SBTarget target)
+    : target_(target), listener_("lldb-eval.target-cache") {
+  listener_.StartListeningForEvents(target_.GetBroadcaster(), kModuleEvents);
+}
+
+TargetCache::~TargetCache() {
+  listener_.StopListeningForEvents(target_.GetBroadcaster(), kModuleEvents);
+}
+
+bool TargetCache::LookupType(llvm::StringRef name, lldb::SBType* type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+
+  auto it = types_.find(name);
+  if (it == types_.end()) {
+    ++stats_.types.misses;
+    return false;
+  }
+
+  ++stats_.types.hits;
+  *type = it->second;
+  return true;
+}
+
+void TargetCache::InsertType(llvm::StringRef name, lldb::SBType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+  types_[name] = type;
+}
+
+bool TargetCache::LookupGlobalVariable(llvm::StringRef name,
+                                       lldb::SBValue* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+
+  auto it = globals_.find(name);
+  if (it == globals_.end()) {
+    ++stats_.globals.misses;
+    return false;
+  }
+
+  ++stats_.globals.hits;
+  GlobalVariable& global = it->second;
+  if (global.address == LLDB_INVALID_ADDRESS) {
+    *value = global.value;
+  } else {
+    *value = target_.CreateValueFromAddress(
+        global.value.GetName(), lldb::SBAddress(global.address, target_),
+        global.type);
+  }
+  return true;
+}
+
+void TargetCache::InsertGlobalVariable(llvm::StringRef name,
+                                       lldb::SBValue value) {
+  // The address of a thread-local variable differs between the threads, so
+  // it's looked up again every time.
+  if (value && value.GetValueType() == lldb::eValueTypeVariableThreadLocal) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+
+  GlobalVariable global;
+  global.value = value;
+  global.address = value ? value.GetLoadAddress() : LLDB_INVALID_ADDRESS;
+  global.type = value ? value.GetType() : lldb::SBType();
+  globals_[name] = global;
+}
+
+bool TargetCache::LookupMember(lldb::SBType record, llvm::StringRef name,
+                               MemberLocation* member) {
+  std::string key = MemberKey(record, name);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+
+  auto it = members_.find(key);
+  if (it == members_.end() || it->second.record != record) {
+    ++stats_.members.misses;
+    return false;
+  }
+
+  ++stats_.members.hits;
+  *member = it->second.location;
+  return true;
+}
+
+void TargetCache::InsertMember(lldb::SBType record, llvm::StringRef name,
+                               const MemberLocation& member) {
+  std::string key = MemberKey(record, name);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  InvalidateIfModulesChanged();
+  members_[key] = Member{record, member};
+}
+
+TargetCacheStats TargetCache::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void TargetCache::InvalidateIfModulesChanged() {
+  // Consume all pending events, a single clear is enough for all of them.
+  bool modules_changed = false;
+  lldb::SBEvent event;
+  while (listener_.GetNextEvent(event)) {
+    modules_changed = true;
+  }
+
+  if (modules_changed) {
+    types_.clear();
+    globals_.clear();
+    members_.clear();
+    ++stats_.invalidations;
+  }
+}
+
+}  // namespace lldb_eval
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_TARGET_CACHE_H_
+#define LLDB_EVAL_TARGET_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "api.h"
+#include "lldb/API/SBListener.h"
+#include "lldb/API/SBTarget.h"
+#include "lldb/API/SBType.h"
+#include "lldb/API/SBValue.h"
+#include "lldb/lldb-types.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace lldb_eval {
+
+// Caches the results of the expensive lookups in the target (e.g. finding types
+// by name). The cache is shared by all expressions evaluated in the same target
+// and is invalidated when the modules of the target are loaded or unloaded.
+// All methods are thread-safe.
+class TargetCache {
+ public:
+  // Returns the cache of the given target, creates it on first use. Returns
+  // nullptr if the target is not valid.
+  static std::shared_ptr<TargetCache> Get(lldb::SBTarget target);
+
+  explicit TargetCache(lldb::SBTarget target);
+  ~TargetCache();
+
+  TargetCache(const TargetCache&) = delete;
+  TargetCache& operator=(const TargetCache&) = delete;
+
+  // Returns true if the type lookup result for `name` is in the cache. Invalid
+  // `type` means the type doesn't exist.
+  bool LookupType(llvm::StringRef name, lldb::SBType* type);
+  void InsertType(llvm::StringRef name, lldb::SBType type);
+
+  // Returns true if the global variable lookup result for `name` is in the
+  // cache. Invalid `value` means there is no such global variable. Thread-local
+  // variables are never cached.
+  bool LookupGlobalVariable(llvm::StringRef name, lldb::SBValue* value);
+  void InsertGlobalVariable(llvm::StringRef name, lldb::SBValue value);
+
+  // Location of a member of a record type, see `LookupMember()`.
+  struct MemberLocation {
+    // False if the member doesn't exist or its location depends on the object
+    // (e.g. bit-fields and members of virtual bases).
+    bool has_offset = false;
+    uint64_t offset = 0;
+    lldb::SBType type;
+  };
+
+  // Returns true if the location of the member `name` of the record type
+  // `record` is in the cache.
+  bool LookupMember(lldb::SBType record, llvm::StringRef name,
+                    MemberLocation* member);
+  void InsertMember(lldb::SBType record, llvm::StringRef name,
+                    const MemberLocation& member);
+
+  TargetCacheStats GetStats();
+
+  // Serializes the evaluations in the target which run on several threads.
+  // The type system of LLDB (the clang ASTContext of the target) isn't
+  // thread-safe, even for the SB API calls which only read the types.
+  std::mutex& evaluation_mutex() { return evaluation_mutex_; }
+
+ private:
+  // Drops the cached results if the modules of the target have changed since
+  // the last call. Must be called with `mutex_` held.
+  void InvalidateIfModulesChanged();
+
+ private:
+  lldb::SBTarget target_;
+  // Receives the module events of the target.
+  lldb::SBListener listener_;
+
+  // Global variables located in memory are stored as the address and the type,
+  // the value itself is read from memory on every lookup. Others (e.g. the
+  // constants without a location) are stored as is.
+  struct GlobalVariable {
+    lldb::SBValue value;
+    lldb::addr_t address;
+    lldb::SBType type;
+  };
+
+  // Members are keyed by the names of the record and the member. The record
+  // type is stored too, since different types can have the same name (e.g.
+  // local classes of different functions).
+  struct Member {
+    lldb::SBType record;
+    MemberLocation location;
+  };
+
+  std::mutex mutex_;
+  std::mutex evaluation_mutex_;
+  llvm::StringMap<lldb::SBType> types_;
+  llvm::StringMap<GlobalVariable> globals_;
+  llvm::StringMap<Member> members_;
+  TargetCacheStats stats_;
+};
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_TARGET_CACHE_H_
@@ -0,0 +1,79 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "type_info.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "lldb/API/SBType.h"
+
+namespace {
+
+thread_local lldb_eval::TypeInfoCache* current_cache = nullptr;
+
+lldb_eval::TypeInfo ComputeTypeInfo(lldb::SBType type) {
+  lldb_eval::TypeInfo info;
+
+  lldb::SBType canonical = type.GetCanonicalType();
+  info.basic_type = canonical.GetBasicType();
+  info.flags = canonical.GetTypeFlags();
+  info.is_pointer = canonical.IsPointerType();
+  info.is_array = canonical.IsArrayType();
+  info.is_reference = canonical.IsReferenceType();
+  info.canonical_unqualified = canonical.GetUnqualifiedType();
+
+  lldb::SBType pointee = type.GetPointeeType();
+  if (pointee.IsValid()) {
+    info.pointee_basic_type = pointee.GetBasicType();
+    info.pointee_size = pointee.GetByteSize();
+  }
+
+  return info;
+}
+
+}  // namespace
+
+namespace lldb_eval {
+
+constexpr size_t TypeInfoCache::kMaxTypes;
+
+TypeInfo TypeInfoCache::Get(lldb::SBType type) {
+  for (auto& entry : types_) {
+    if (entry.first == type) {
+      return entry.second;
+    }
+  }
+
+  TypeInfo info = ComputeTypeInfo(type);
+  if (types_.size() < kMaxTypes) {
+    types_.emplace_back(type, info);
+  }
+  return info;
+}
+
+TypeInfoScope::TypeInfoScope(TypeInfoCache* cache)
+    : previous_(current_cache) {
+  current_cache = cache;
+}
+
+TypeInfoScope::~TypeInfoScope() { current_cache = previous_; }
+
+TypeInfoCache* GetCurrentTypeInfoCache() { return current_cache; }
+
+TypeInfo GetTypeInfo(lldb::SBType type) {
+  return current_cache ? current_cache->Get(type) : ComputeTypeInfo(type);
+}
+
+}  // namespace lldb_eval
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LLDB_EVAL_TYPE_INFO_H_
+#define LLDB_EVAL_TYPE_INFO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "lldb/API/SBType.h"
+#include "lldb/lldb-enumerations.h"
+
+namespace lldb_eval {
+
+// Properties of a type which the interpreter checks over and over again (e.g.
+// whether a value is a pointer). Every query of `SBType` goes into the type
+// system of LLDB and most of them create a new `SBType`, so they are computed
+// once per type.
+struct TypeInfo {
+  // Properties of the canonical type.
+  lldb::BasicType basic_type = lldb::eBasicTypeInvalid;
+  uint32_t flags = 0;
+  bool is_pointer = false;
+  bool is_array = false;
+  bool is_reference = false;
+  // The canonical type without qualifiers, e.g. to check if two pointer types
+  // are compatible.
+  lldb::SBType canonical_unqualified;
+  // Properties of the pointee of pointers and references.
+  lldb::BasicType pointee_basic_type = lldb::eBasicTypeInvalid;
+  uint64_t pointee_size = 0;
+};
+
+// Caches the properties of the types used by the evaluations, e.g. of a batch
+// of expressions. `SBType` can't be hashed, so the types are searched linearly
+// and every comparison gets the compiler types of both sides. A lookup costs up
+// to `kMaxTypes` such comparisons, which must stay cheaper than the queries it
+// saves (compare BM_TypeInfoCachedWorstCase with BM_TypeInfoComputed in
+// eval_benchmark). An evaluation uses only a handful of types, so the lookups
+// usually end early.
+class TypeInfoCache {
+ public:
+  // Types beyond the limit are not cached.
+  static constexpr size_t kMaxTypes = 64;
+
+  TypeInfoCache() = default;
+
+  TypeInfoCache(const TypeInfoCache&) = delete;
+  TypeInfoCache& operator=(const TypeInfoCache&) = delete;
+
+  TypeInfo Get(lldb::SBType type);
+
+ private:
+  std::vector<std::pair<lldb::SBType, TypeInfo>> types_;
+};
+
+// Makes the evaluations running on the current thread use `cache` until the
+// end of the scope.
+class TypeInfoScope {
+ public:
+  explicit TypeInfoScope(TypeInfoCache* cache);
+  ~TypeInfoScope();
+
+  TypeInfoScope(const TypeInfoScope&) = delete;
+  TypeInfoScope& operator=(const TypeInfoScope&) = delete;
+
+ private:
+  TypeInfoCache* previous_;
+};
+
+// Returns the type info cache of the current evaluation, or nullptr if there
+// is none.
+TypeInfoCache* GetCurrentTypeInfoCache();
+
+// Returns the properties of `type`, through the cache of the current
+// evaluation if there is one.
+TypeInfo GetTypeInfo(lldb::SBType type);
+
+}  // namespace lldb_eval
+
+#endif  // LLDB_EVAL_TYPE_INFO_H_
@@ -20,6 +20,8 @@
 #include "lldb/API/SBValue.h"
 #include "lldb/lldb-enumerations.h"
 #include "scalar.h"
+#include "stats.h"
+#include "type_info.h"
 
 namespace {
 
@@ -36,6 +38,10 @@ lldb::SBValue CreateSbValue(lldb::SBTarget target, const T& value,
   data.SetData(error, bytes, bytes_length, target.GetByteOrder(),
                static_cast<uint8_t>(target.GetAddressByteSize()));
 
+  if (lldb_eval::EvalStats* stats = lldb_eval::GetCurrentStats()) {
+    ++stats->sb_values_created;
+  }
+
   // CreateValueFromData copies the data referenced by `bytes` to its own
   // storage. `value` should be valid up until this point.
   return target.CreateValueFromData("result", data, type);
@@ -53,7 +59,7 @@ namespace lldb_eval {
 
 bool Value::IsScalar() {
   if (type_ == Type::SB_VALUE) {
-    return sb_value_.GetType().GetCanonicalType().GetBasicType() !=
+    return GetTypeInfo(sb_value_.GetType()).basic_type !=
            lldb::eBasicTypeInvalid;
   }
   return type_ == Type::BOOLEAN || type_ == Type::SCALAR;
@@ -61,7 +67,7 @@ bool Value::IsScalar() {
 
 bool Value::IsPointer() {
   if (type_ == Type::SB_VALUE) {
-    return sb_value_.GetType().GetCanonicalType().IsPointerType();
+    return GetTypeInfo(sb_value_.GetType()).is_pointer;
   }
   return type_ == Type::POINTER;
 }
@@ -122,7 +128,8 @@ lldb::SBValue Value::AsSbValue(lldb::SBTarget target) const {
     case Type::SCALAR: {
       switch (scalar_.type_) {
         case Scalar::Type::INVALID: {
-          break;
+          // E.g. the result of a bitwise operation on a floating point value.
+          return lldb::SBValue();
         }
         case Scalar::Type::INT32: {
           return CreateSbValue(target, scalar_.value_.int32_,
@@ -149,6 +156,7 @@ lldb::SBValue Value::AsSbValue(lldb::SBTarget target) const {
                                lldb::eBasicTypeDouble);
         }
       }
+      unreachable("Scalar::Type enum wasn't exhausted in the switch.");
     }
     case Type::POINTER: {
       return CreateSbValue(target, pointer_.addr(), pointer_.type());
@@ -168,7 +176,7 @@ Value CastScalarToBasicType(const Scalar& value, lldb::SBType type,
   // target type (e.g. "wchar_t" or "unsigned short").
   lldb::SBValue ret;
 
-  switch (type.GetCanonicalType().GetBasicType()) {
+  switch (GetTypeInfo(type).basic_type) {
     case lldb::eBasicTypeChar:
     case lldb::eBasicTypeSignedChar:
       ret = CreateSbValue(target, value.GetAs<char>(), type);
@@ -234,7 +242,7 @@ Value CastPointerToBasicType(const Pointer& value, lldb::SBType type,
 
   uint64_t addr = value.addr();
 
-  switch (type.GetCanonicalType().GetBasicType()) {
+  switch (GetTypeInfo(type).basic_type) {
     case lldb::eBasicTypeChar:
     case lldb::eBasicTypeSignedChar:
       ret = CreateSbValue(target, static_cast<char>(addr), type);
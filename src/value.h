@@ -19,7 +19,9 @@
 
 #include <cstdint>
 #include <iostream>
+#include <new>
 #include <string>
+#include <utility>
 
 #include "lldb/API/SBTarget.h"
 #include "lldb/API/SBValue.h"
@@ -28,6 +30,9 @@
 
 namespace lldb_eval {
 
+// Result of the evaluation. Only the alternative of the current type is
+// constructed, so scalars (e.g. temporaries of the arithmetic) don't carry the
+// SB handles of pointers and values.
 class Value {
  public:
   enum class Type {
@@ -39,32 +44,49 @@ class Value {
   };
 
  public:
-  Value() : type_(Type::INVALID) {}
-
-  explicit Value(bool value) {
-    type_ = Type::BOOLEAN;
-    scalar_ = Scalar(static_cast<int32_t>(value));
-    is_rvalue_ = true;
-  }
-  explicit Value(const Scalar& value) {
-    type_ = Type::SCALAR;
-    scalar_ = value;
-    is_rvalue_ = true;
+  Value() : type_(Type::INVALID), is_rvalue_(false) {}
+
+  explicit Value(bool value)
+      : type_(Type::BOOLEAN),
+        is_rvalue_(true),
+        scalar_(static_cast<int32_t>(value)) {}
+  explicit Value(const Scalar& value)
+      : type_(Type::SCALAR), is_rvalue_(true), scalar_(value) {}
+  explicit Value(const Pointer& value)
+      : type_(Type::POINTER), is_rvalue_(true), pointer_(value) {}
+  explicit Value(lldb::SBValue value, bool is_rvalue = false)
+      : type_(Type::SB_VALUE), is_rvalue_(is_rvalue), sb_value_(value) {}
+
+  Value(const Value& other) { ConstructFrom(other); }
+  // The moved-from value becomes invalid.
+  Value(Value&& other) noexcept {
+    ConstructFrom(std::move(other));
+    other.Reset();
   }
-  explicit Value(const Pointer& value) {
-    type_ = Type::POINTER;
-    pointer_ = value;
-    is_rvalue_ = true;
+
+  Value& operator=(const Value& other) {
+    if (this != &other) {
+      Reset();
+      ConstructFrom(other);
+    }
+    return *this;
   }
-  explicit Value(lldb::SBValue value, bool is_rvalue = false) {
-    type_ = Type::SB_VALUE;
-    sb_value_ = value;
-    is_rvalue_ = is_rvalue;
+  Value& operator=(Value&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ConstructFrom(std::move(other));
+      other.Reset();
+    }
+    return *this;
   }
 
+  ~Value() { Reset(); }
+
  public:
   bool IsValid() const { return type_ != Type::INVALID; }
 
+  Type type() const { return type_; }
+
   bool IsRValue() const { return is_rvalue_; }
 
   bool IsScalar();
@@ -78,13 +100,56 @@ class Value {
   explicit operator bool() const { return IsValid(); }
 
  private:
+  // Constructs the alternative of `other` in place. The current alternative
+  // must be already destroyed.
+  template <typename V>
+  void ConstructFrom(V&& other) {
+    type_ = other.type_;
+    is_rvalue_ = other.is_rvalue_;
+    switch (type_) {
+      case Type::INVALID:
+        break;
+      case Type::BOOLEAN:
+      case Type::SCALAR:
+        new (&scalar_) Scalar(std::forward<V>(other).scalar_);
+        break;
+      case Type::POINTER:
+        new (&pointer_) Pointer(std::forward<V>(other).pointer_);
+        break;
+      case Type::SB_VALUE:
+        new (&sb_value_) lldb::SBValue(std::forward<V>(other).sb_value_);
+        break;
+    }
+  }
+
+  // Destroys the current alternative and makes the value invalid.
+  void Reset() {
+    switch (type_) {
+      case Type::INVALID:
+      case Type::BOOLEAN:
+      case Type::SCALAR:
+        // Scalars are trivially destructible.
+        break;
+      case Type::POINTER:
+        pointer_.~Pointer();
+        break;
+      case Type::SB_VALUE:
+        sb_value_.~SBValue();
+        break;
+    }
+    type_ = Type::INVALID;
+    is_rvalue_ = false;
+  }
+
   Type type_;
   bool is_rvalue_;
 
-  // Possible values.
-  Scalar scalar_;
-  Pointer pointer_;
-  lldb::SBValue sb_value_;
+  // Possible values, `scalar_` is used by BOOLEAN and SCALAR.
+  union {
+    Scalar scalar_;
+    Pointer pointer_;
+    lldb::SBValue sb_value_;
+  };
 };
 
 Value CastScalarToBasicType(const Scalar& value, lldb::SBType type,
@@ -27,6 +27,7 @@ static void TestArithmetic() {
   unsigned long long ull_zero = 0;
 
   // BREAK(TestArithmetic)
+  // BREAK(TestConstantFolding)
 }
 
 static void TestPointerArithmetic() {
@@ -62,6 +63,7 @@ static void TestLogicalOperators() {
   } s;
 
   // BREAK(TestLogicalOperators)
+  // BREAK(TestBytecode)
 }
 
 static void TestLocalVariables() {
@@ -78,6 +80,17 @@ static void TestIndirection() {
   int val = 1;
   int* p = &val;
 
+  // Referenced by the benchmarks of the member access chains.
+  struct Node {
+    int value;
+    Node* next;
+  };
+  Node n3 = {3, nullptr};
+  Node n2 = {2, &n3};
+  Node n1 = {1, &n2};
+  Node n0 = {0, &n1};
+  Node* head = &n0;
+
   // BREAK(TestIndirection)
 }
 
@@ -91,6 +104,9 @@ class C {
 int globalVar = 0xDEADBEEF;
 extern int externGlobalVar;
 
+// Referenced by TestGlobalVariableCache
+thread_local int threadLocalVar = 42;
+
 class TestMethods {
  public:
   void TestInstanceVariables() {
@@ -148,6 +164,8 @@ static void TestSubscript() {
   uint8_arr[255] = 0xAB;
 
   // BREAK(TestSubscript)
+  // BREAK(TestMemoryCache)
+  // BREAK(TestMemberCache)
 }
 
 // Referenced by TestCStyleCast
@@ -318,6 +336,34 @@ static void TestTemplateTypes() {
   // BREAK(TestTemplateTypes)
 }
 
+static void TestBreakpointCondition() {
+  C c;
+  int sum = 0;
+
+  // The breakpoint is hit on every iteration, the condition decides whether
+  // the debugger stops.
+  for (int i = 0; i < 1000000; ++i) {
+    // BREAK(TestBreakpointCondition)
+    // BREAK(TestEvaluateCondition)
+    // BREAK(TestWatchList)
+    sum += i;
+  }
+}
+
+static void TestCompiledExpression() {
+  int a = 1;
+  int b = 2;
+
+  // BREAK(TestCompiledExpression)
+  // BREAK(TestEvaluateInFrames)
+  // BREAK(TestTypeCache)
+  // BREAK(TestGlobalVariableCache)
+  // BREAK(TestEvaluateExpressions)
+  // BREAK(TestEvalStats)
+  // BREAK(TestFrameVariables)
+  // BREAK(TestEvaluateExpressionNative)
+}
+
 int main() {
   TestMethods tm;
 
@@ -332,6 +378,8 @@ int main() {
   TestCStyleCast();
   TestQualifiedId();
   TestTemplateTypes();
+  TestBreakpointCondition();
+  TestCompiledExpression();
 
   // break here
 }